@@ -1,6 +1,8 @@
 #ifndef HOIST_CLOCK_H
 #define HOIST_CLOCK_H
 
+#include <atomic>
+
 namespace Hoist {
 
 typedef long long nanos_t;
@@ -16,5 +18,17 @@ class SystemClock final : public Clock {
   nanos_t nanos() override;
 };
 
+// ManualClock only moves when told to, for driving time in tests and
+// benchmarks. It is safe to read while another thread advances it.
+class ManualClock final : public Clock {
+ public:
+  ManualClock() : nanos_(0) {}
+  nanos_t nanos() override { return nanos_; }
+  void advance(nanos_t nanos) { nanos_ += nanos; }
+
+ private:
+  std::atomic<nanos_t> nanos_;
+};
+
 }  // namespace Hoist
 #endif
\ No newline at end of file
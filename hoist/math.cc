@@ -14,4 +14,10 @@ double roll() {
 }
 
 }  // namespace RNG
+
+uint64_t Random::randomSeed() {
+  std::random_device rd{};
+  return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
 }  // namespace Hoist
\ No newline at end of file
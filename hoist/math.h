@@ -1,6 +1,9 @@
 #ifndef HOIST_MATH_H
 #define HOIST_MATH_H
 
+#include <cstdint>
+#include <random>
+
 namespace Hoist {
 namespace RNG {
 
@@ -21,6 +24,38 @@ const T rand(const T& toExclusive) {
 }
 
 }  // namespace RNG
+
+// Random generates random values from its own generator. Unlike RNG, two
+// generators with the same seed generate the same values, and generators are
+// independent, so each may be used by a different thread.
+class Random final {
+ public:
+  explicit Random(const uint64_t seed) : engine_(seed), distribution_(0, 1) {}
+
+  // get a seed that is different every time
+  static uint64_t randomSeed();
+
+  // roll will generate a random value in the range [0, 1)
+  double roll() { return distribution_(engine_); }
+
+  // rand will generate a random value in the range [from, toExclusive)
+  template <typename T>
+  const T rand(const T& from, const T& toExclusive) {
+    double result = from + (toExclusive - from) * roll();
+    return static_cast<T>(result);
+  }
+
+  // to will generate a random value in the range [0, toExclusive)
+  template <typename T>
+  const T rand(const T& toExclusive) {
+    return rand(0, toExclusive);
+  }
+
+ private:
+  std::mt19937_64 engine_;
+  std::uniform_real_distribution<> distribution_;
+};
+
 }  // namespace Hoist
 
 #endif
\ No newline at end of file
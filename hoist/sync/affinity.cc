@@ -0,0 +1,58 @@
+#include "hoist/sync/affinity.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef __linux__
+
+int availableCpus() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return 1;
+  }
+  int count = CPU_COUNT(&allowed);
+  return count > 0 ? count : 1;
+}
+
+Hoist::Status pinThisThread(const int cpu) {
+  if (cpu < 0) {
+    return Hoist::Status(Hoist::error::INVALID_ARGUMENT, "negative cpu");
+  }
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return Hoist::Status(Hoist::error::INTERNAL, strerror(errno));
+  }
+  // find the cpu-th allowed cpu, wrapping around
+  int skip = cpu % availableCpus();
+  for (int i = 0; i < CPU_SETSIZE; i++) {
+    if (!CPU_ISSET(i, &allowed) || skip-- > 0) {
+      continue;
+    }
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    CPU_SET(i, &pinned);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+    if (rc != 0) {
+      return Hoist::Status(Hoist::error::INTERNAL, strerror(rc));
+    }
+    return Hoist::Status();
+  }
+  return Hoist::Status(Hoist::error::INTERNAL, "no cpu to pin to");
+}
+
+#else
+
+int availableCpus() { return 1; }
+
+Hoist::Status pinThisThread(const int cpu) {
+  return Hoist::Status(Hoist::error::UNIMPLEMENTED,
+                       "cannot pin threads on this platform");
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef HOIST_SYNC_AFFINITY_H
+#define HOIST_SYNC_AFFINITY_H
+
+#include "hoist/status.h"
+
+// get the number of cpus the process may run on, at least one
+int availableCpus();
+
+// Run the calling thread only on one of the cpus the process may run on.
+// cpu counts from 0 up to availableCpus(), and wraps around past it, so
+// threads can be spread over the cpus by numbering them.
+Hoist::Status pinThisThread(const int cpu);
+
+#endif
@@ -0,0 +1,34 @@
+#include "hoist/sync/affinity.h"
+
+#include <sched.h>
+#include <thread>
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(AffinityTest, SomeCpusAreAvailable) { EXPECT_GE(availableCpus(), 1); }
+
+TEST(AffinityTest, PinsToOneCpu) {
+  std::thread pinned([]() {
+    ASSERT_TRUE(pinThisThread(0).ok());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(cpus), &cpus));
+    EXPECT_EQ(1, CPU_COUNT(&cpus));
+  });
+  pinned.join();
+}
+
+TEST(AffinityTest, WrapsAround) {
+  std::thread pinned(
+      []() { EXPECT_TRUE(pinThisThread(availableCpus() * 3 + 1).ok()); });
+  pinned.join();
+  EXPECT_FALSE(pinThisThread(-1).ok());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,61 @@
+#ifndef HOIST_SYNC_MPSC_QUEUE_H
+#define HOIST_SYNC_MPSC_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+// MpscQueue is an unbounded queue that any number of threads push to without
+// taking a lock, and that a single thread empties all at once.
+//
+// Pushing links a node onto a shared stack with a compare-and-swap. Draining
+// swaps the whole stack out and reverses it, so values come out in the order
+// they were pushed.
+template <typename T>
+class MpscQueue final {
+ public:
+  MpscQueue() : head_(nullptr) {}
+  ~MpscQueue() {
+    std::vector<T> discarded;
+    drain(&discarded);
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // add a value, from any thread
+  void push(T value) {
+    Node* node =
+        new Node{std::move(value), head_.load(std::memory_order_relaxed)};
+    while (!head_.compare_exchange_weak(node->next, node,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+
+  // move every value pushed so far onto the end of out, oldest first.
+  // only one thread may drain at a time.
+  void drain(std::vector<T>* out) {
+    Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+    const size_t first = out->size();
+    while (node != nullptr) {
+      out->push_back(std::move(node->value));
+      Node* next = node->next;
+      delete node;
+      node = next;
+    }
+    std::reverse(out->begin() + first, out->end());
+  }
+
+ private:
+  struct Node {
+    T value;
+    Node* next;
+  };
+
+  // the most recently pushed value
+  std::atomic<Node*> head_;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "hoist/sync/mpsc_queue.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(MpscQueueTest, DrainsInPushOrder) {
+  MpscQueue<int> queue;
+  queue.push(1);
+  queue.push(2);
+  queue.push(3);
+
+  std::vector<int> out = {0};
+  queue.drain(&out);
+
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), out);
+  out.clear();
+  queue.drain(&out);
+  EXPECT_TRUE(out.empty());
+}
+
+TEST(MpscQueueTest, MoveOnlyValues) {
+  MpscQueue<std::unique_ptr<int>> queue;
+  queue.push(std::unique_ptr<int>(new int(7)));
+
+  std::vector<std::unique_ptr<int>> out;
+  queue.drain(&out);
+
+  ASSERT_EQ(1u, out.size());
+  EXPECT_EQ(7, *out[0]);
+}
+
+TEST(MpscQueueTest, ConcurrentProducers) {
+  static constexpr int kProducers = 8;
+  static constexpr int kValues = 10000;
+  MpscQueue<std::pair<int, int>> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = 0; i < kValues; i++) {
+        queue.push(std::make_pair(p, i));
+      }
+    });
+  }
+  // drain while the producers are still pushing
+  std::vector<std::pair<int, int>> out;
+  while (out.size() < kProducers * kValues) {
+    queue.drain(&out);
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+
+  // every value arrives once, in the order its producer pushed it
+  std::vector<int> next(kProducers, 0);
+  for (const std::pair<int, int>& value : out) {
+    ASSERT_EQ(next[value.first], value.second);
+    next[value.first]++;
+  }
+  EXPECT_EQ(std::vector<int>(kProducers, kValues), next);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
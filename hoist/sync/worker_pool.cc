@@ -0,0 +1,97 @@
+#include "hoist/sync/worker_pool.h"
+
+#include <algorithm>
+
+namespace {
+
+// get where a chunk of a loop starts
+size_t chunkBegin(const size_t n, const int chunks, const int chunk) {
+  return n * chunk / chunks;
+}
+
+}  // namespace
+
+WorkerPool::WorkerPool(const int threads)
+    : generation_(0),
+      stopping_(false),
+      fn_(nullptr),
+      n_(0),
+      chunks_(0),
+      pending_(0) {
+  for (int i = 1; i < threads; i++) {
+    workers_.emplace_back([this, i]() { work(i); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkerPool::parallelFor(const size_t n, const size_t min_chunk,
+                             const ChunkFn& fn) {
+  if (n == 0) {
+    return;
+  }
+  // as many chunks as there are threads, as long as each is big enough
+  size_t most = std::max<size_t>(1, n / std::max<size_t>(min_chunk, 1));
+  int chunks = static_cast<int>(std::min<size_t>(size(), most));
+  if (chunks == 1) {
+    fn(0, 0, n);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fn_ = &fn;
+    n_ = n;
+    chunks_ = chunks;
+    pending_ = chunks - 1;
+    generation_++;
+  }
+  start_.notify_all();
+
+  fn(0, 0, chunkBegin(n, chunks, 1));
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this]() { return pending_ == 0; });
+  fn_ = nullptr;
+}
+
+void WorkerPool::work(const int worker) {
+  uint64_t seen = 0;
+  while (true) {
+    const ChunkFn* fn;
+    size_t n;
+    int chunks;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock,
+                  [this, seen]() { return stopping_ || generation_ != seen; });
+      if (stopping_) {
+        return;
+      }
+      seen = generation_;
+      fn = fn_;
+      n = n_;
+      chunks = chunks_;
+    }
+    // workers past the number of chunks sit this loop out
+    if (worker >= chunks) {
+      continue;
+    }
+    (*fn)(worker, chunkBegin(n, chunks, worker),
+          chunkBegin(n, chunks, worker + 1));
+    if (--pending_ == 0) {
+      // take the lock so the caller cannot miss the notification
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_.notify_one();
+    }
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef HOIST_SYNC_WORKER_POOL_H
+#define HOIST_SYNC_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// WorkerPool splits loops across a fixed set of threads.
+//
+// The thread calling parallelFor() works on the first chunk itself, so a pool
+// of one thread starts no threads at all and runs every loop inline. Only one
+// thread may call parallelFor() at a time.
+class WorkerPool final {
+ public:
+  // the function run on each chunk of a loop, with the chunk's number and the
+  // range [begin, end) of the loop it covers
+  typedef std::function<void(int chunk, size_t begin, size_t end)> ChunkFn;
+
+  explicit WorkerPool(const int threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // get the number of threads, including the caller, and so the most chunks
+  // any loop is split into
+  int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Run fn over [0, n) in contiguous chunks of at least min_chunk, in
+  // parallel, and return once every chunk is done. Chunks are numbered in
+  // order, and where they start only depends on n, min_chunk and size().
+  void parallelFor(const size_t n, const size_t min_chunk, const ChunkFn& fn);
+
+ private:
+  void work(const int worker);
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  // signalled when a loop starts, or the pool stops
+  std::condition_variable start_;
+  // signalled when the last chunk of a loop is done
+  std::condition_variable done_;
+  // counts loops, so each worker runs each loop once
+  uint64_t generation_;
+  bool stopping_;
+  // the current loop
+  const ChunkFn* fn_;
+  size_t n_;
+  int chunks_;
+  // chunks of the current loop still running on workers
+  std::atomic<int> pending_;
+};
+
+#endif
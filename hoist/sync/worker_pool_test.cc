@@ -0,0 +1,79 @@
+#include "hoist/sync/worker_pool.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(WorkerPoolTest, CoversEveryIndexOnce) {
+  WorkerPool pool(4);
+  for (size_t n : {0, 1, 7, 100, 1000, 4097}) {
+    std::vector<std::atomic<int>> seen(n);
+    pool.parallelFor(n, 1, [&seen](int chunk, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        seen[i]++;
+      }
+    });
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_EQ(seen[i], 1) << "n=" << n << " i=" << i;
+    }
+  }
+}
+
+TEST(WorkerPoolTest, ChunksAreContiguousAndInOrder) {
+  WorkerPool pool(3);
+  std::vector<size_t> begins(pool.size(), 0);
+  std::vector<size_t> ends(pool.size(), 0);
+  pool.parallelFor(
+      300, 1, [&begins, &ends](int chunk, size_t begin, size_t end) {
+        begins[chunk] = begin;
+        ends[chunk] = end;
+      });
+  EXPECT_EQ(begins[0], 0);
+  EXPECT_EQ(ends[0], begins[1]);
+  EXPECT_EQ(ends[1], begins[2]);
+  EXPECT_EQ(ends[2], 300);
+}
+
+TEST(WorkerPoolTest, SmallLoopsRunInline) {
+  WorkerPool pool(4);
+  std::thread::id caller = std::this_thread::get_id();
+  int chunks = 0;
+  pool.parallelFor(100, 64, [&](int chunk, size_t begin, size_t end) {
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+    chunks++;
+  });
+  EXPECT_EQ(chunks, 1);
+}
+
+TEST(WorkerPoolTest, SplitsByMinimumChunk) {
+  WorkerPool pool(8);
+  std::atomic<int> chunks(0);
+  pool.parallelFor(200, 64, [&chunks](int chunk, size_t begin, size_t end) {
+    EXPECT_GE(end - begin, 64);
+    chunks++;
+  });
+  EXPECT_EQ(chunks, 3);
+}
+
+TEST(WorkerPoolTest, RunsManyLoops) {
+  WorkerPool pool(4);
+  std::atomic<int64_t> sum(0);
+  for (int loop = 0; loop < 1000; loop++) {
+    pool.parallelFor(64, 1, [&sum](int chunk, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        sum += i;
+      }
+    });
+  }
+  EXPECT_EQ(sum, 1000 * (63 * 64 / 2));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,471 @@
+#include "net/spacefight/async_service.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <grpc++/alarm.h>
+#include "hoist/logging.h"
+#include "hoist/statusor.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/update_context.h"
+
+namespace spacefight {
+
+// Call is a call in progress. Completion queue tags point at a Tag, which
+// says which call an event belongs to and what the event is.
+class AsyncSpacefightService::Call {
+ public:
+  virtual ~Call() {}
+
+  // handle a completed operation
+  virtual void proceed(const int event, const bool ok) = 0;
+
+  struct Tag {
+    Call* call;
+    int event;
+  };
+};
+
+// LoginCall {
+
+class AsyncSpacefightService::LoginCall final : public Call {
+ public:
+  LoginCall(AsyncSpacefightService* service, grpc::ServerCompletionQueue* queue)
+      : service_(service), queue_(queue), responder_(&context_) {}
+
+  // wait for the next Login call, returning false if the queue is closed
+  bool request() {
+    return service_->whileServing([this]() {
+      service_->service_.RequestLogin(&context_, &request_, &responder_,
+                                      queue_, queue_, &requested_);
+    });
+  }
+
+  void proceed(const int event, const bool ok) override {
+    if (event == kRequested && ok) {
+      accept(service_, queue_);
+      grpc::Status status = grpc::Status::OK;
+      if (!service_->rooms_.login(request_, &response_)) {
+        status = grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                              "no room for another game");
+      }
+      if (service_->whileServing([this, &status]() {
+            responder_.Finish(response_, status, &finished_);
+          })) {
+        return;
+      }
+    }
+    delete this;
+  }
+
+  // wait for a call on a queue
+  static void accept(AsyncSpacefightService* service,
+                     grpc::ServerCompletionQueue* queue) {
+    LoginCall* call = new LoginCall(service, queue);
+    if (!call->request()) {
+      delete call;
+    }
+  }
+
+ private:
+  enum Event { kRequested, kFinished };
+
+  AsyncSpacefightService* service_;
+  grpc::ServerCompletionQueue* queue_;
+  grpc::ServerContext context_;
+  Registration request_;
+  Token response_;
+  grpc::ServerAsyncResponseWriter<Token> responder_;
+  Tag requested_{this, kRequested};
+  Tag finished_{this, kFinished};
+};
+
+// } LoginCall
+
+// UpdateCall {
+
+// An UpdateCall keeps one read outstanding for as long as the client sends
+// input, and at most one write. It owns itself while any operation is in
+// flight, and the writer may hold it for as long as it takes to offer it a
+// snapshot. The frame is made and written on the call's completion queue,
+// woken by an alarm, so a room's streams are served by every queue thread.
+// It joins its player's room once the first input names the player, and
+// closes the room if it is the last stream to leave.
+class AsyncSpacefightService::UpdateCall final
+    : public Call,
+      public std::enable_shared_from_this<UpdateCall> {
+ public:
+  UpdateCall(AsyncSpacefightService* service,
+             grpc::ServerCompletionQueue* queue)
+      : service_(service),
+        queue_(queue),
+        stream_(&context_),
+        pending_(0),
+        offering_(false),
+        writing_(false),
+        closing_(false),
+        finishing_(false) {}
+
+  ~UpdateCall() {
+    if (client_) {
+      service_->clients_.remove(client_.get());
+    }
+  }
+
+  // wait for the next Update call on a queue
+  static void accept(AsyncSpacefightService* service,
+                     grpc::ServerCompletionQueue* queue) {
+    std::shared_ptr<UpdateCall> call =
+        std::make_shared<UpdateCall>(service, queue);
+    std::scoped_lock<std::mutex> lock(call->mutex_);
+    call->self_ = call;
+    call->start([&call]() {
+      call->service_->service_.RequestUpdate(&call->context_, &call->stream_,
+                                             call->queue_, call->queue_,
+                                             &call->requested_);
+    });
+    call->releaseIfDone();
+  }
+
+  void proceed(const int event, const bool ok) override {
+    // released last, after the lock, in case it is the last owner
+    std::shared_ptr<UpdateCall> self;
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_--;
+    switch (event) {
+      case kRequested:
+        if (!ok) {
+          break;
+        }
+        accept(service_, queue_);
+        configureUpdateContext(&context_);
+        read();
+        break;
+      case kRead:
+        if (ok && !client_) {
+          Hoist::Status joined = join();
+          if (!joined.ok()) {
+            DLOG("unknown player");
+            closing_ = true;
+            finish(grpc::Status(grpc::StatusCode::NOT_FOUND,
+                                joined.error_message()));
+            break;
+          }
+        }
+        if (ok && client_->onInput(input_)) {
+          read();
+        } else {
+          DLOG(ok ? "client quit" : "read ended");
+          close();
+        }
+        break;
+      case kOffer:
+        offering_ = false;
+        if (ok) {
+          send();
+        }
+        offered_.reset();
+        break;
+      case kWrite:
+        client_->sendRate().finished(service_->clock_.nanos());
+        writing_ = false;
+        frame_.reset();
+        if (closing_) {
+          finish();
+        } else if (!ok) {
+          // the outstanding read fails next, and closes the stream
+          DLOG("write ended");
+          context_.TryCancel();
+        }
+        break;
+      case kFinished:
+        break;
+    }
+    self = releaseIfDone();
+    std::shared_ptr<Room> closed = std::move(closed_);
+    lock.unlock();
+    // the room's writer may be waiting for this call's lock to offer it a
+    // snapshot, so it is only stopped once the lock is released
+    if (closed) {
+      service_->closeRoom(closed.get());
+    }
+  }
+
+  // offer a snapshot to send, unless the last frame is still being written
+  // or the client is not due another yet. a snapshot offered before the
+  // last one is taken is replaced.
+  void offer(std::shared_ptr<const Snapshot> snapshot) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    if (!due(service_->clock_.nanos())) {
+      return;
+    }
+    offered_ = std::move(snapshot);
+    if (!offering_) {
+      offering_ = start([this]() {
+        alarm_.Set(queue_, gpr_now(GPR_CLOCK_MONOTONIC), &offer_);
+      });
+    }
+  }
+
+ private:
+  enum Event { kRequested, kRead, kOffer, kWrite, kFinished };
+
+  AsyncSpacefightService* service_;
+  grpc::ServerCompletionQueue* queue_;
+  // the player's room, stream and token, once the first input arrives.
+  // the stream plays in the room, so is declared after it.
+  std::shared_ptr<Room> room_;
+  std::unique_ptr<ClientStream> client_;
+  std::string token_;
+  // the room, if this call was the last to leave it
+  std::shared_ptr<Room> closed_;
+  grpc::ServerContext context_;
+  grpc::ServerAsyncReaderWriter<Frame, PlayerInput> stream_;
+  Tag requested_{this, kRequested};
+  Tag read_{this, kRead};
+  Tag offer_{this, kOffer};
+  Tag write_{this, kWrite};
+  // wakes the completion queue to send the offered snapshot
+  grpc::Alarm alarm_;
+  Tag finished_{this, kFinished};
+
+  std::mutex mutex_;
+  // this call, while any operation is in flight
+  std::shared_ptr<UpdateCall> self_;
+  int pending_;
+  PlayerInput input_;
+  // the snapshot to send next, while the alarm is set
+  std::shared_ptr<const Snapshot> offered_;
+  bool offering_;
+  // the frame being written
+  std::shared_ptr<const Frame> frame_;
+  bool writing_;
+  bool closing_;
+  bool finishing_;
+
+  // start an operation, counting it as pending if it started
+  template <typename F>
+  bool start(F&& op) {
+    if (service_->whileServing(op)) {
+      pending_++;
+      return true;
+    }
+    return false;
+  }
+
+  // whether the client is open and due another frame
+  bool due(const Hoist::nanos_t now) const {
+    return !closing_ && client_ && client_->sendRate().due(now);
+  }
+
+  // start writing a frame of the offered snapshot, if still due one
+  void send() {
+    Hoist::nanos_t now = service_->clock_.nanos();
+    if (!offered_ || !due(now)) {
+      return;
+    }
+    frame_ = client_->next(std::move(offered_));
+    writing_ = start([this]() { stream_.Write(*frame_, &write_); });
+    if (writing_) {
+      client_->sendRate().started(now, frame_->ByteSizeLong());
+    }
+  }
+
+  void read() {
+    if (!start([this]() { stream_.Read(&input_, &read_); })) {
+      close();
+    }
+  }
+
+  // join the room of the player the first input names
+  Hoist::Status join() {
+    Hoist::StatusOr<std::shared_ptr<Room>> found =
+        service_->rooms_.find(input_.token());
+    if (!found.ok()) {
+      return found.status();
+    }
+    room_ = found.ValueOrDie();
+    token_ = input_.token();
+    client_.reset(new ClientStream(room_->game, room_->sessions,
+                                   service_->slowest_send_));
+    service_->clients_.add(client_.get());
+    service_->addStream(room_, shared_from_this());
+    return Hoist::Status::OK;
+  }
+
+  // the client is gone, finish once the last write is done
+  void close() {
+    closing_ = true;
+    if (client_) {
+      service_->removeStream(room_.get(), shared_from_this());
+      service_->clients_.remove(client_.get());
+      client_->close();
+      closed_ = service_->rooms_.leave(token_);
+    }
+    if (!writing_) {
+      finish();
+    }
+  }
+
+  void finish(const grpc::Status& status = grpc::Status::OK) {
+    if (finishing_) {
+      return;
+    }
+    finishing_ = true;
+    start([this, &status]() { stream_.Finish(status, &finished_); });
+  }
+
+  // give up ownership of this call once nothing is in flight
+  std::shared_ptr<UpdateCall> releaseIfDone() {
+    if (pending_ > 0) {
+      return nullptr;
+    }
+    return std::move(self_);
+  }
+};
+
+// } UpdateCall
+
+template <typename F>
+bool AsyncSpacefightService::whileServing(F&& start) {
+  std::shared_lock<std::shared_timed_mutex> lock(serving_mutex_);
+  if (!serving_) {
+    return false;
+  }
+  start();
+  return true;
+}
+
+void AsyncSpacefightService::registerWith(grpc::ServerBuilder* builder) {
+  builder->RegisterService(&service_);
+  for (int i = 0; i < num_threads_; i++) {
+    queues_.push_back(builder->AddCompletionQueue());
+  }
+}
+
+void AsyncSpacefightService::start() {
+  ILOG("serving spacefight on " << num_threads_ << " completion queues");
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(serving_mutex_);
+    serving_ = true;
+  }
+  running_ = true;
+  for (auto& queue : queues_) {
+    LoginCall::accept(this, queue.get());
+    UpdateCall::accept(this, queue.get());
+    threads_.emplace_back(&AsyncSpacefightService::poll, this, queue.get());
+  }
+}
+
+void AsyncSpacefightService::shutdown() {
+  std::unordered_map<Room*, std::thread> writers;
+  {
+    // no more writers start once running_ is false
+    std::scoped_lock<std::mutex> lock(streams_mutex_);
+    running_ = false;
+    writers.swap(writers_);
+  }
+  for (auto& writer : writers) {
+    writer.second.join();
+  }
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(serving_mutex_);
+    serving_ = false;
+  }
+  for (auto& queue : queues_) {
+    queue->Shutdown();
+  }
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+  std::scoped_lock<std::mutex> lock(streams_mutex_);
+  streams_.clear();
+}
+
+void AsyncSpacefightService::poll(grpc::ServerCompletionQueue* queue) {
+  void* tag;
+  bool ok;
+  while (queue->Next(&tag, &ok)) {
+    Call::Tag* event = static_cast<Call::Tag*>(tag);
+    event->call->proceed(event->event, ok);
+  }
+  DLOG("completion queue drained");
+}
+
+void AsyncSpacefightService::addStream(std::shared_ptr<Room> room,
+                                       std::shared_ptr<UpdateCall> stream) {
+  std::scoped_lock<std::mutex> lock(streams_mutex_);
+  streams_[room.get()].insert(std::move(stream));
+  if (running_ && writers_.count(room.get()) == 0) {
+    writers_[room.get()] =
+        std::thread(&AsyncSpacefightService::writeFrames, this, room);
+  }
+}
+
+void AsyncSpacefightService::removeStream(
+    Room* room, const std::shared_ptr<UpdateCall>& stream) {
+  std::scoped_lock<std::mutex> lock(streams_mutex_);
+  auto search = streams_.find(room);
+  if (search != streams_.end()) {
+    search->second.erase(stream);
+  }
+}
+
+void AsyncSpacefightService::closeRoom(Room* room) {
+  std::thread writer;
+  {
+    // the writer stops once its room has no streams entry
+    std::scoped_lock<std::mutex> lock(streams_mutex_);
+    streams_.erase(room);
+    auto search = writers_.find(room);
+    if (search != writers_.end()) {
+      writer = std::move(search->second);
+      writers_.erase(search);
+    }
+  }
+  // unless shutdown already took the writer to join it
+  if (writer.joinable()) {
+    writer.join();
+  }
+}
+
+void AsyncSpacefightService::writeFrames(std::shared_ptr<Room> room) {
+  static constexpr Hoist::nanos_t wait =
+      std::chrono::nanoseconds(settings::snapshot_wait).count();
+  std::vector<std::shared_ptr<UpdateCall>> streams;
+  int64_t tick = -1;
+  while (running_) {
+    std::shared_ptr<const Snapshot> snapshot =
+        room->game.waitForSnapshot(tick, wait);
+    if (!snapshot) {
+      // the game has ended, wait for the room to close or to be shut down
+      {
+        std::scoped_lock<std::mutex> lock(streams_mutex_);
+        if (streams_.count(room.get()) == 0) {
+          return;
+        }
+      }
+      std::this_thread::sleep_for(settings::snapshot_wait);
+      continue;
+    }
+    if (snapshot->tick <= tick) {
+      continue;
+    }
+    tick = snapshot->tick;
+    {
+      std::scoped_lock<std::mutex> lock(streams_mutex_);
+      auto search = streams_.find(room.get());
+      if (search == streams_.end()) {
+        return;
+      }
+      streams.assign(search->second.begin(), search->second.end());
+    }
+    for (const std::shared_ptr<UpdateCall>& stream : streams) {
+      stream->offer(snapshot);
+    }
+    streams.clear();
+  }
+}
+
+}  // namespace spacefight
@@ -0,0 +1,113 @@
+#ifndef NET_SPACEFIGHT_ASYNC_SERVICE_H
+#define NET_SPACEFIGHT_ASYNC_SERVICE_H
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <grpc++/grpc++.h>
+#include "hoist/clock.h"
+#include "net/spacefight/rooms.h"
+#include "net/spacefight/stream.h"
+#include "proto/spacefight/spacefight.pb.h"
+#include "proto/spacefight/spacefight_service.grpc.pb.h"
+
+namespace spacefight {
+
+// AsyncSpacefightService serves the Spacefight service on completion queues.
+//
+// Every call is a small state machine driven by a fixed pool of threads, one
+// per completion queue, no matter how many clients are connected. Each
+// Update stream plays in the room its player logged into. A writer thread
+// per room wakes each of the room's streams with every snapshot as soon as
+// the game publishes it, skipping streams still busy with the last one, and
+// the completion queue threads make and write the frames.
+// Streams that are slow to take their frames are offered fewer of them, but
+// at least one every slowest_send nanoseconds.
+//
+// Usage:
+//   AsyncSpacefightService service(rooms, 4);
+//   service.registerWith(&builder);
+//   std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+//   service.start();
+//   ...
+//   server->Shutdown();
+//   service.shutdown();
+class AsyncSpacefightService final {
+ public:
+  AsyncSpacefightService(
+      RoomManager& rooms, const int num_threads,
+      const Hoist::nanos_t slowest_send = ClientStream::kSlowest)
+      : rooms_(rooms),
+        num_threads_(num_threads),
+        slowest_send_(slowest_send),
+        running_(false),
+        serving_(false) {}
+
+  AsyncSpacefightService(const AsyncSpacefightService&) = delete;
+  AsyncSpacefightService& operator=(const AsyncSpacefightService&) = delete;
+
+  // add the service and its completion queues to a server being built
+  void registerWith(grpc::ServerBuilder* builder);
+
+  // start serving calls, once the server is built
+  void start();
+
+  // stop serving calls and join every thread, once the server is shut down
+  void shutdown();
+
+  // the open Update streams
+  const ClientStreams& clients() const { return clients_; }
+
+ private:
+  class Call;
+  class LoginCall;
+  class UpdateCall;
+
+  RoomManager& rooms_;
+  Spacefight::AsyncService service_;
+  const int num_threads_;
+  const Hoist::nanos_t slowest_send_;
+  Hoist::SystemClock clock_;
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> running_;
+
+  // operations may only start on a queue until it is shut down
+  std::shared_timed_mutex serving_mutex_;
+  bool serving_;
+
+  // streams the writers send frames to, and the writers, by open room
+  std::mutex streams_mutex_;
+  std::unordered_map<Room*, std::unordered_set<std::shared_ptr<UpdateCall>>>
+      streams_;
+  std::unordered_map<Room*, std::thread> writers_;
+  ClientStreams clients_;
+
+  // start an operation, unless the queues are shutting down.
+  // returns whether the operation was started.
+  template <typename F>
+  bool whileServing(F&& start);
+
+  // handle events from a completion queue until it is shut down
+  void poll(grpc::ServerCompletionQueue* queue);
+
+  // add a stream to the streams of a room, starting a writer for the room
+  // if it has none
+  void addStream(std::shared_ptr<Room> room,
+                 std::shared_ptr<UpdateCall> stream);
+  void removeStream(Room* room, const std::shared_ptr<UpdateCall>& stream);
+  // stop the writer of a room that has closed
+  void closeRoom(Room* room);
+
+  // send every stream in a room a frame per world update. the writer holds
+  // the room, so it outlives the room's closing until it stops.
+  void writeFrames(std::shared_ptr<Room> room);
+};
+
+}  // namespace spacefight
+
+#endif
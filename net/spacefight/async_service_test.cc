@@ -0,0 +1,139 @@
+#include "net/spacefight/async_service.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <grpc++/grpc++.h>
+#include "gtest/gtest.h"
+#include "net/spacefight/rooms.h"
+#include "proto/spacefight/spacefight.pb.h"
+#include "proto/spacefight/spacefight_service.grpc.pb.h"
+
+namespace spacefight {
+namespace {
+
+RoomOptions options() {
+  RoomOptions options;
+  options.max_rooms = 2;
+  options.bots = 0;
+  return options;
+}
+
+// serves a real game on a local port
+class AsyncServiceTest : public ::testing::Test {
+ protected:
+  AsyncServiceTest() : rooms_(options()), service_(rooms_, 2) {
+    grpc::ServerBuilder builder;
+    int port = 0;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(),
+                             &port);
+    service_.registerWith(&builder);
+    server_ = builder.BuildAndStart();
+    service_.start();
+    stub_ = Spacefight::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(port),
+                            grpc::InsecureChannelCredentials()));
+  }
+
+  ~AsyncServiceTest() {
+    server_->Shutdown(std::chrono::system_clock::now() +
+                      std::chrono::seconds(1));
+    service_.shutdown();
+  }
+
+  // play as a new player until it has been sent some frames, then quit.
+  // returns the number of frames received.
+  int play(const std::string& username, const int frames,
+           const std::string& room = "") {
+    Registration registration;
+    registration.set_username(username);
+    registration.set_room(room);
+    Token token;
+    grpc::ClientContext login;
+    if (!stub_->Login(&login, registration, &token).ok()) {
+      return 0;
+    }
+
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() +
+                         std::chrono::seconds(10));
+    auto stream = stub_->Update(&context);
+    PlayerInput input;
+    input.set_token(token.token());
+    stream->Write(input);
+    Frame frame;
+    int received = 0;
+    while (received < frames && stream->Read(&frame)) {
+      received++;
+      input.set_ack_tick(frame.tick());
+      stream->Write(input);
+    }
+    input.set_quit(true);
+    stream->Write(input);
+    stream->WritesDone();
+    while (stream->Read(&frame)) {
+    }
+    stream->Finish();
+    return received;
+  }
+
+  RoomManager rooms_;
+  AsyncSpacefightService service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<Spacefight::Stub> stub_;
+};
+
+TEST_F(AsyncServiceTest, SendsToEveryStreamInARoom) {
+  static constexpr int kStreams = 32;
+  static constexpr int kFrames = 5;
+  std::atomic<int> served(0);
+  std::vector<std::thread> clients;
+  for (int i = 0; i < kStreams; i++) {
+    clients.emplace_back([this, i, &served]() {
+      if (play("pilot" + std::to_string(i), kFrames) == kFrames) {
+        served++;
+      }
+    });
+  }
+  for (std::thread& client : clients) {
+    client.join();
+  }
+
+  EXPECT_EQ(kStreams, served);
+  EXPECT_EQ(1u, rooms_.size());
+}
+
+TEST_F(AsyncServiceTest, ClosesRoomsOnceEmpty) {
+  EXPECT_EQ(3, play("pilot", 3, "arena"));
+  EXPECT_EQ(1u, rooms_.size());
+
+  // the place it took is free for another room, again and again
+  EXPECT_EQ(3, play("pilot", 3, "other"));
+  EXPECT_EQ(3, play("pilot", 3, "arena"));
+  EXPECT_EQ(1u, rooms_.size());
+}
+
+TEST_F(AsyncServiceTest, RejectsUnknownPlayers) {
+  grpc::ClientContext context;
+  context.set_deadline(std::chrono::system_clock::now() +
+                       std::chrono::seconds(10));
+  auto stream = stub_->Update(&context);
+  PlayerInput input;
+  input.set_token("nobody");
+  stream->Write(input);
+  stream->WritesDone();
+  Frame frame;
+  EXPECT_FALSE(stream->Read(&frame));
+  EXPECT_EQ(grpc::StatusCode::NOT_FOUND, stream->Finish().error_code());
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,45 @@
+#include "net/spacefight/baseline.h"
+
+#include "net/spacefight/elements.h"
+
+namespace spacefight {
+
+void BaselineTracker::ack(const int64_t tick) {
+  int64_t acked = acked_.load();
+  while (tick > acked && !acked_.compare_exchange_weak(acked, tick)) {
+  }
+}
+
+std::shared_ptr<const Frame> BaselineTracker::next(
+    const std::shared_ptr<const Snapshot>& snapshot,
+    const bool particle_events) {
+  // everything up to the acknowledged tick has been received,
+  // the acknowledged snapshot itself becomes the new baseline.
+  int64_t acked = acked_.load();
+  while (!sent_.empty() && sent_.front()->tick <= acked) {
+    if (sent_.front()->tick == acked) {
+      baseline_ = std::move(sent_.front());
+    }
+    sent_.pop_front();
+  }
+
+  bool keyframe = !baseline_ ||
+                  snapshot->tick - last_keyframe_ >= settings::keyframe_ticks ||
+                  sent_.size() >= settings::max_unacked_frames;
+  if (keyframe) {
+    // acknowledgements stopped arriving, start over from this keyframe
+    if (sent_.size() >= settings::max_unacked_frames) {
+      baseline_.reset();
+      sent_.clear();
+    }
+    last_keyframe_ = snapshot->tick;
+  }
+  sent_.push_back(snapshot);
+
+  if (keyframe) {
+    return std::shared_ptr<const Frame>(snapshot, &snapshot->frame);
+  }
+  return snapshot->deltaFrom(*baseline_, particle_events);
+}
+
+}  // namespace spacefight
@@ -0,0 +1,46 @@
+#ifndef NET_SPACEFIGHT_BASELINE_H
+#define NET_SPACEFIGHT_BASELINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include "net/spacefight/snapshot.h"
+#include "proto/spacefight/spacefight.pb.h"
+
+namespace spacefight {
+
+// BaselineTracker follows which snapshots one client has been sent and which
+// it has acknowledged, and picks whether to send it a keyframe or a delta.
+//
+// ack() may be called from the thread reading the stream while next() is
+// called from the thread writing it.
+class BaselineTracker final {
+ public:
+  BaselineTracker() : acked_(0), last_keyframe_(0) {}
+
+  BaselineTracker(const BaselineTracker&) = delete;
+  BaselineTracker& operator=(const BaselineTracker&) = delete;
+
+  // record that the client has decoded the frame for a tick
+  void ack(const int64_t tick);
+
+  // get the frame to send for a snapshot, and remember it as sent.
+  // deltas send bullets and explosions as events if particle_events is set.
+  std::shared_ptr<const Frame> next(
+      const std::shared_ptr<const Snapshot>& snapshot,
+      const bool particle_events = false);
+
+ private:
+  // newest acknowledged tick
+  std::atomic<int64_t> acked_;
+  // the newest acknowledged snapshot, that deltas are computed against
+  std::shared_ptr<const Snapshot> baseline_;
+  // snapshots sent but not yet acknowledged, oldest first
+  std::deque<std::shared_ptr<const Snapshot>> sent_;
+  int64_t last_keyframe_;
+};
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,96 @@
+#include "net/spacefight/baseline.h"
+
+#include <memory>
+#include "gtest/gtest.h"
+#include "net/spacefight/delta.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/snapshot.h"
+
+namespace spacefight {
+namespace {
+
+std::shared_ptr<const Snapshot> makeSnapshot(int64_t tick) {
+  std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+  snapshot->tick = tick;
+  snapshot->compress = false;
+  Player* player = snapshot->world.add_players();
+  player->set_id(1);
+  game::Body* body = player->mutable_ship()->mutable_body();
+  body->mutable_phys()->mutable_pos()->set_x(tick);
+  encodeFrame(tick, snapshot->world, false, &snapshot->frame);
+  return snapshot;
+}
+
+TEST(BaselineTrackerTest, KeyframeUntilAcknowledged) {
+  BaselineTracker tracker;
+
+  EXPECT_TRUE(tracker.next(makeSnapshot(1))->has_world());
+  EXPECT_TRUE(tracker.next(makeSnapshot(2))->has_world());
+}
+
+TEST(BaselineTrackerTest, DeltaAgainstAcknowledgedTick) {
+  BaselineTracker tracker;
+  tracker.next(makeSnapshot(1));
+  tracker.next(makeSnapshot(2));
+  tracker.ack(1);
+
+  std::shared_ptr<const Frame> frame = tracker.next(makeSnapshot(3));
+
+  ASSERT_TRUE(frame->has_delta());
+  EXPECT_EQ(3, frame->tick());
+  WorldDelta delta;
+  ASSERT_TRUE(delta.ParseFromString(frame->delta()));
+  EXPECT_EQ(1, delta.baseline_tick());
+  ASSERT_EQ(1, delta.players_size());
+  EXPECT_EQ(3, delta.players(0).ship().body().phys().pos().x());
+}
+
+TEST(BaselineTrackerTest, DeltasAreShared) {
+  std::shared_ptr<const Snapshot> first = makeSnapshot(1);
+  std::shared_ptr<const Snapshot> second = makeSnapshot(2);
+  BaselineTracker a;
+  BaselineTracker b;
+  a.next(first);
+  b.next(first);
+  a.ack(1);
+  b.ack(1);
+
+  EXPECT_EQ(a.next(second).get(), b.next(second).get());
+}
+
+TEST(BaselineTrackerTest, PeriodicKeyframe) {
+  BaselineTracker tracker;
+  tracker.next(makeSnapshot(1));
+  for (int64_t tick = 2; tick <= settings::keyframe_ticks; tick++) {
+    tracker.ack(tick - 1);
+    ASSERT_TRUE(tracker.next(makeSnapshot(tick))->has_delta()) << tick;
+  }
+  tracker.ack(settings::keyframe_ticks);
+
+  EXPECT_TRUE(
+      tracker.next(makeSnapshot(settings::keyframe_ticks + 1))->has_world());
+}
+
+TEST(BaselineTrackerTest, KeyframeWhenAcknowledgementsStop) {
+  BaselineTracker tracker;
+  tracker.next(makeSnapshot(1));
+  tracker.ack(1);
+  int64_t tick = 2;
+  for (size_t i = 0; i < settings::max_unacked_frames; i++) {
+    ASSERT_TRUE(tracker.next(makeSnapshot(tick++))->has_delta());
+  }
+
+  EXPECT_TRUE(tracker.next(makeSnapshot(tick++))->has_world());
+  // and keep sending keyframes until the client catches up
+  EXPECT_TRUE(tracker.next(makeSnapshot(tick++))->has_world());
+  tracker.ack(tick - 1);
+  EXPECT_TRUE(tracker.next(makeSnapshot(tick++))->has_delta());
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
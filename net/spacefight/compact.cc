@@ -0,0 +1,165 @@
+#include "net/spacefight/compact.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include "net/spacefight/elements.h"
+#include "net/spacefight/physics.h"
+
+namespace spacefight {
+
+namespace {
+
+using google::protobuf::RepeatedPtrField;
+
+static constexpr float kTurn = 2 * M_PI;
+
+int32_t quantize(const float v, const float scale) {
+  return static_cast<int32_t>(std::lround(v / scale));
+}
+
+uint32_t packAngle(const game::Vector& rotation) {
+  if (rotation.x() == 0 && rotation.y() == 0) {
+    return 0;
+  }
+  long step = std::lround(phys::angle(rotation) / kTurn * compact::angle_steps);
+  step %= compact::angle_steps;
+  return static_cast<uint32_t>(step < 0 ? step + compact::angle_steps : step);
+}
+
+float unpackAngle(const uint32_t step) {
+  return static_cast<float>(step) * kTurn / compact::angle_steps;
+}
+
+uint32_t packFlags(const Player& player) {
+  uint32_t flags = NONE;
+  if (player.is_new()) flags |= IS_NEW;
+  if (player.is_dead()) flags |= IS_DEAD;
+  if (player.is_thrusting()) flags |= IS_THRUSTING;
+  return flags;
+}
+
+// T is either a Bullet or an Explosion
+template <typename T>
+void compactParticles(const RepeatedPtrField<T>& particles,
+                      CompactParticles* out) {
+  // id gaps are only small, and unsigned, in id order
+  std::vector<int> order(particles.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&particles](int a, int b) {
+    return particles.Get(a).id() < particles.Get(b).id();
+  });
+  int64_t last_id = 0;
+  for (int i : order) {
+    const T& particle = particles.Get(i);
+    const game::Physics& physics = particle.body().phys();
+    out->add_id_gap(particle.id() - last_id);
+    out->add_player_id(particle.player_id());
+    out->add_x(quantize(physics.pos().x(), compact::position_scale));
+    out->add_y(quantize(physics.pos().y(), compact::position_scale));
+    out->add_dx(quantize(physics.vel().x(), compact::velocity_scale));
+    out->add_dy(quantize(physics.vel().y(), compact::velocity_scale));
+    out->add_lifespan(static_cast<uint32_t>(
+        std::max(0, quantize(particle.lifespan(), compact::lifespan_scale))));
+    last_id = particle.id();
+  }
+}
+
+// T is either a Bullet or an Explosion
+template <typename T>
+void expandParticles(const CompactWorld& compacted, const CompactParticles& in,
+                     const float size,
+                     const std::unordered_map<int64_t, PlayerMeta>& known,
+                     RepeatedPtrField<T>* out) {
+  int64_t id = 0;
+  for (int i = 0; i < in.id_gap_size(); i++) {
+    id += in.id_gap(i);
+    T* particle = out->Add();
+    particle->set_id(id);
+    particle->set_player_id(in.player_id(i));
+    particle->set_lifespan(in.lifespan(i) * compacted.lifespan_scale());
+    auto search = known.find(in.player_id(i));
+    if (search != known.end()) {
+      particle->mutable_color()->CopyFrom(search->second.color());
+    }
+    float dx = in.dx(i) * compacted.velocity_scale();
+    float dy = in.dy(i) * compacted.velocity_scale();
+    game::Body* body = particle->mutable_body();
+    phys::set(body->mutable_phys(), in.x(i) * compacted.position_scale(),
+              in.y(i) * compacted.position_scale(), dx, dy);
+    phys::set(body->mutable_size(), size, size);
+    // particles face the way they move
+    phys::set(body->mutable_rotation(), dx, dy);
+  }
+}
+
+}  // namespace
+
+void compactWorld(const World& world, const bool metadata,
+                  CompactWorld* compacted) {
+  compacted->set_position_scale(compact::position_scale);
+  compacted->set_velocity_scale(compact::velocity_scale);
+  compacted->set_lifespan_scale(compact::lifespan_scale);
+  compacted->set_ship_size(ships::size);
+  compacted->set_bullet_size(bullets::size);
+  compacted->set_explosion_size(explosions::size);
+
+  CompactShips* ships = compacted->mutable_ships();
+  for (int i = 0; i < world.players_size(); i++) {
+    const Player& player = world.players(i);
+    const game::Body& body = player.ship().body();
+    ships->add_id(player.id());
+    ships->add_x(quantize(body.phys().pos().x(), compact::position_scale));
+    ships->add_y(quantize(body.phys().pos().y(), compact::position_scale));
+    ships->add_dx(quantize(body.phys().vel().x(), compact::velocity_scale));
+    ships->add_dy(quantize(body.phys().vel().y(), compact::velocity_scale));
+    ships->add_angle(packAngle(body.rotation()));
+    ships->add_flags(packFlags(player));
+    if (metadata) {
+      PlayerMeta* meta = compacted->add_players();
+      meta->set_id(player.id());
+      meta->set_username(player.username());
+      meta->mutable_color()->CopyFrom(player.color());
+    }
+  }
+  compactParticles(world.bullets(), compacted->mutable_bullets());
+  compactParticles(world.explosions(), compacted->mutable_explosions());
+}
+
+void expandWorld(const CompactWorld& compacted,
+                 std::unordered_map<int64_t, PlayerMeta>* known,
+                 World* world) {
+  for (const PlayerMeta& meta : compacted.players()) {
+    (*known)[meta.id()] = meta;
+  }
+
+  const CompactShips& ships = compacted.ships();
+  const float size = compacted.ship_size();
+  for (int i = 0; i < ships.id_size(); i++) {
+    Player* player = world->add_players();
+    player->set_id(ships.id(i));
+    auto search = known->find(ships.id(i));
+    if (search != known->end()) {
+      player->set_username(search->second.username());
+      player->mutable_color()->CopyFrom(search->second.color());
+    }
+    player->set_is_new(ships.flags(i) & IS_NEW);
+    player->set_is_dead(ships.flags(i) & IS_DEAD);
+    player->set_is_thrusting(ships.flags(i) & IS_THRUSTING);
+    game::Body* body = player->mutable_ship()->mutable_body();
+    phys::set(body->mutable_phys(), ships.x(i) * compacted.position_scale(),
+              ships.y(i) * compacted.position_scale(),
+              ships.dx(i) * compacted.velocity_scale(),
+              ships.dy(i) * compacted.velocity_scale());
+    phys::set(body->mutable_size(), size, size);
+    float angle = unpackAngle(ships.angle(i));
+    phys::set(body->mutable_rotation(), std::cos(angle), std::sin(angle));
+  }
+  expandParticles(compacted, compacted.bullets(), compacted.bullet_size(),
+                  *known, world->mutable_bullets());
+  expandParticles(compacted, compacted.explosions(),
+                  compacted.explosion_size(), *known,
+                  world->mutable_explosions());
+}
+
+}  // namespace spacefight
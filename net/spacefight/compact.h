@@ -0,0 +1,22 @@
+#ifndef NET_SPACEFIGHT_COMPACT_H
+#define NET_SPACEFIGHT_COMPACT_H
+
+#include <cstdint>
+#include <unordered_map>
+#include "proto/spacefight/spacefight.pb.h"
+
+namespace spacefight {
+
+// write a world into its compact representation, with the metadata of
+// every player if metadata is set, otherwise with none.
+void compactWorld(const World& world, const bool metadata,
+                  CompactWorld* compacted);
+
+// turn a compact world back into a world, as a client would.
+// known holds metadata from earlier frames and is updated from this one.
+void expandWorld(const CompactWorld& compacted,
+                 std::unordered_map<int64_t, PlayerMeta>* known, World* world);
+
+}  // namespace spacefight
+
+#endif
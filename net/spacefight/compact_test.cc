@@ -0,0 +1,182 @@
+#include "net/spacefight/compact.h"
+
+#include <cmath>
+#include <random>
+#include "gtest/gtest.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/physics.h"
+#include "net/spacefight/snapshot.h"
+
+namespace spacefight {
+namespace {
+
+// a busy world, shaped like one produced by the game
+World makeWorld() {
+  std::mt19937 rng(99);
+  std::uniform_real_distribution<float> pos(-world::spawn_radius,
+                                            world::spawn_radius);
+  std::uniform_real_distribution<float> vel(-ships::max_vel, ships::max_vel);
+  std::uniform_real_distribution<float> life(0, bullets::lifespan);
+  World world;
+  for (int i = 0; i < 64; i++) {
+    Player* player = world.add_players();
+    player->set_id(i + 1);
+    player->set_username("player" + std::to_string(i));
+    player->mutable_color()->set_aarrggbb(0xff00ff00 + i);
+    player->set_is_new(i % 5 == 0);
+    player->set_is_dead(i % 7 == 0);
+    player->set_is_thrusting(i % 2 == 0);
+    game::Body* body = player->mutable_ship()->mutable_body();
+    phys::set(body->mutable_phys(), pos(rng), pos(rng), vel(rng), vel(rng));
+    phys::set(body->mutable_size(), ships::size, ships::size);
+    phys::set(body->mutable_rotation(), vel(rng), vel(rng));
+  }
+  for (int i = 0; i < 512; i++) {
+    Bullet* bullet = world.add_bullets();
+    bullet->set_id(1000 + i * 3);
+    bullet->set_player_id(i % 64 + 1);
+    bullet->set_lifespan(life(rng));
+    bullet->mutable_color()->set_aarrggbb(0xff00ff00 + i % 64);
+    game::Body* body = bullet->mutable_body();
+    float dx = vel(rng) + bullets::vel;
+    float dy = vel(rng);
+    phys::set(body->mutable_phys(), pos(rng), pos(rng), dx, dy);
+    phys::set(body->mutable_size(), bullets::size, bullets::size);
+    phys::set(body->mutable_rotation(), dx, dy);
+  }
+  for (int i = 0; i < 16; i++) {
+    Explosion* explosion = world.add_explosions();
+    explosion->set_id(i + 1);
+    explosion->set_player_id(i + 1);
+    explosion->set_lifespan(explosions::lifespan / 2);
+    explosion->mutable_color()->set_aarrggbb(0xff00ff00 + i);
+    game::Body* body = explosion->mutable_body();
+    phys::set(body->mutable_phys(), pos(rng), pos(rng), vel(rng), vel(rng));
+    phys::set(body->mutable_size(), explosions::size, explosions::size);
+  }
+  return world;
+}
+
+void expectNear(const game::Vector& a, const game::Vector& b, float step) {
+  EXPECT_NEAR(a.x(), b.x(), step / 2 + 1e-3f);
+  EXPECT_NEAR(a.y(), b.y(), step / 2 + 1e-3f);
+}
+
+TEST(CompactTest, AtLeastThreeTimesSmaller) {
+  World world = makeWorld();
+  CompactWorld compacted;
+  compactWorld(world, true, &compacted);
+
+  EXPECT_GE(world.ByteSizeLong(), 3 * compacted.ByteSizeLong())
+      << world.ByteSizeLong() << " vs " << compacted.ByteSizeLong();
+}
+
+TEST(CompactTest, RoundTripWithinOneStep) {
+  World world = makeWorld();
+  CompactWorld compacted;
+  compactWorld(world, true, &compacted);
+
+  std::unordered_map<int64_t, PlayerMeta> known;
+  World expanded;
+  expandWorld(compacted, &known, &expanded);
+
+  ASSERT_EQ(world.players_size(), expanded.players_size());
+  for (int i = 0; i < world.players_size(); i++) {
+    const Player& a = world.players(i);
+    const Player& b = expanded.players(i);
+    EXPECT_EQ(a.id(), b.id());
+    EXPECT_EQ(a.username(), b.username());
+    EXPECT_EQ(a.color().aarrggbb(), b.color().aarrggbb());
+    EXPECT_EQ(a.is_new(), b.is_new());
+    EXPECT_EQ(a.is_dead(), b.is_dead());
+    EXPECT_EQ(a.is_thrusting(), b.is_thrusting());
+    const game::Body& ab = a.ship().body();
+    const game::Body& bb = b.ship().body();
+    expectNear(ab.phys().pos(), bb.phys().pos(), compact::position_scale);
+    expectNear(ab.phys().vel(), bb.phys().vel(), compact::velocity_scale);
+    float step = 2 * M_PI / compact::angle_steps;
+    float turn = phys::angle(bb.rotation()) - phys::angle(ab.rotation());
+    EXPECT_LE(std::fabs(std::remainder(turn, 2 * M_PI)), step / 2 + 1e-3f);
+  }
+
+  ASSERT_EQ(world.bullets_size(), expanded.bullets_size());
+  for (int i = 0; i < world.bullets_size(); i++) {
+    const Bullet& a = world.bullets(i);
+    const Bullet& b = expanded.bullets(i);
+    EXPECT_EQ(a.id(), b.id());
+    EXPECT_EQ(a.player_id(), b.player_id());
+    EXPECT_EQ(a.color().aarrggbb(), b.color().aarrggbb());
+    EXPECT_NEAR(a.lifespan(), b.lifespan(), compact::lifespan_scale);
+    expectNear(a.body().phys().pos(), b.body().phys().pos(),
+               compact::position_scale);
+  }
+  EXPECT_EQ(world.explosions_size(), expanded.explosions_size());
+}
+
+TEST(CompactTest, ParticlesAreSortedById) {
+  World world;
+  for (int64_t id : {9, 4, 6}) {
+    world.add_bullets()->set_id(id);
+  }
+  CompactWorld compacted;
+  compactWorld(world, true, &compacted);
+
+  std::unordered_map<int64_t, PlayerMeta> known;
+  World expanded;
+  expandWorld(compacted, &known, &expanded);
+  ASSERT_EQ(3, expanded.bullets_size());
+  EXPECT_EQ(4, expanded.bullets(0).id());
+  EXPECT_EQ(6, expanded.bullets(1).id());
+  EXPECT_EQ(9, expanded.bullets(2).id());
+}
+
+TEST(CompactTest, MetadataForAllPlayersOrNone) {
+  World world = makeWorld();
+
+  CompactWorld first;
+  compactWorld(world, true, &first);
+  EXPECT_EQ(world.players_size(), first.players_size());
+
+  CompactWorld later;
+  compactWorld(world, false, &later);
+  EXPECT_EQ(0, later.players_size());
+
+  // metadata from earlier frames is still used
+  std::unordered_map<int64_t, PlayerMeta> known;
+  World expanded;
+  expandWorld(first, &known, &expanded);
+  expanded.Clear();
+  expandWorld(later, &known, &expanded);
+  EXPECT_EQ(world.players(3).username(), expanded.players(3).username());
+}
+
+TEST(CompactTest, SnapshotSharesEncodings) {
+  Snapshot snapshot;
+  snapshot.tick = 70;
+  snapshot.compress = false;
+  snapshot.world = makeWorld();
+
+  std::shared_ptr<const Frame> a = snapshot.compactSince(false);
+  std::shared_ptr<const Frame> b = snapshot.compactSince(false);
+  std::shared_ptr<const Frame> fresh = snapshot.compactSince(true);
+
+  // streams that know every player share one encoding
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(fresh, snapshot.compactSince(true));
+  EXPECT_NE(a, fresh);
+  EXPECT_EQ(70, a->tick());
+  EXPECT_EQ(Frame::RAW, a->encoding());
+  CompactWorld decoded;
+  ASSERT_TRUE(decoded.ParseFromString(a->compact_world()));
+  EXPECT_EQ(0, decoded.players_size());
+  ASSERT_TRUE(decoded.ParseFromString(fresh->compact_world()));
+  EXPECT_EQ(snapshot.world.players_size(), decoded.players_size());
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,190 @@
+#include "net/spacefight/delta.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace spacefight {
+
+namespace {
+
+using google::protobuf::RepeatedField;
+using google::protobuf::RepeatedPtrField;
+
+// Equality
+
+bool equal(const game::Vector& a, const game::Vector& b) {
+  return a.x() == b.x() && a.y() == b.y();
+}
+
+bool equal(const game::Body& a, const game::Body& b) {
+  return equal(a.phys().pos(), b.phys().pos()) &&
+         equal(a.phys().vel(), b.phys().vel()) &&
+         equal(a.phys().acc(), b.phys().acc()) && equal(a.size(), b.size()) &&
+         equal(a.rotation(), b.rotation());
+}
+
+bool equal(const Player& a, const Player& b) {
+  return a.is_new() == b.is_new() && a.is_dead() == b.is_dead() &&
+         a.is_thrusting() == b.is_thrusting() &&
+         a.color().aarrggbb() == b.color().aarrggbb() &&
+         equal(a.ship().body(), b.ship().body()) &&
+         a.username() == b.username();
+}
+
+// T is either a Bullet or an Explosion
+template <typename T>
+bool equal(const T& a, const T& b) {
+  return a.lifespan() == b.lifespan() && a.player_id() == b.player_id() &&
+         a.color().aarrggbb() == b.color().aarrggbb() &&
+         equal(a.body(), b.body());
+}
+
+// Diffing
+
+template <typename T>
+void diff(const RepeatedPtrField<T>& baseline,
+          const RepeatedPtrField<T>& current, RepeatedPtrField<T>* changed,
+          RepeatedField<google::protobuf::int64>* removed) {
+  std::unordered_map<int64_t, int> before;
+  before.reserve(baseline.size());
+  for (int i = 0; i < baseline.size(); i++) {
+    before[baseline.Get(i).id()] = i;
+  }
+  std::vector<bool> kept(baseline.size(), false);
+  for (const T& entity : current) {
+    auto search = before.find(entity.id());
+    if (search == before.end()) {
+      changed->Add()->CopyFrom(entity);
+      continue;
+    }
+    kept[search->second] = true;
+    if (!equal(baseline.Get(search->second), entity)) {
+      changed->Add()->CopyFrom(entity);
+    }
+  }
+  for (int i = 0; i < baseline.size(); i++) {
+    if (!kept[i]) {
+      removed->Add(baseline.Get(i).id());
+    }
+  }
+}
+
+// T is either a Bullet or an Explosion
+template <typename T>
+void diffEvents(const RepeatedPtrField<T>& baseline,
+                const RepeatedPtrField<T>& current, const float elapsed,
+                RepeatedPtrField<T>* spawned,
+                RepeatedField<google::protobuf::int64>* removed) {
+  std::unordered_set<int64_t> before;
+  before.reserve(baseline.size());
+  for (const T& entity : baseline) {
+    before.insert(entity.id());
+  }
+  std::unordered_set<int64_t> after;
+  after.reserve(current.size());
+  for (const T& entity : current) {
+    after.insert(entity.id());
+    if (before.count(entity.id()) == 0) {
+      spawned->Add()->CopyFrom(entity);
+    }
+  }
+  // the client drops the ones whose lifespan ran out by itself
+  for (const T& entity : baseline) {
+    if (after.count(entity.id()) == 0 && entity.lifespan() > elapsed) {
+      removed->Add(entity.id());
+    }
+  }
+}
+
+// move and age every bullet or explosion, dropping the ones that expire,
+// preserving the order of what is left
+template <typename T>
+void extrapolate(const float elapsed, RepeatedPtrField<T>* entities) {
+  int kept = 0;
+  for (int i = 0; i < entities->size(); i++) {
+    T* entity = entities->Mutable(i);
+    entity->set_lifespan(entity->lifespan() - elapsed);
+    if (entity->lifespan() <= 0) {
+      continue;
+    }
+    game::Physics* phys = entity->mutable_body()->mutable_phys();
+    game::Vector* pos = phys->mutable_pos();
+    pos->set_x(pos->x() + phys->vel().x() * elapsed);
+    pos->set_y(pos->y() + phys->vel().y() * elapsed);
+    entities->SwapElements(kept++, i);
+  }
+  while (entities->size() > kept) {
+    entities->RemoveLast();
+  }
+}
+
+template <typename T>
+void apply(const RepeatedPtrField<T>& changed,
+           const RepeatedField<google::protobuf::int64>& removed,
+           RepeatedPtrField<T>* entities) {
+  // remove, preserving the order of what is left
+  if (removed.size() > 0) {
+    std::unordered_set<int64_t> gone(removed.begin(), removed.end());
+    int kept = 0;
+    for (int i = 0; i < entities->size(); i++) {
+      if (gone.count(entities->Get(i).id()) == 0) {
+        entities->SwapElements(kept++, i);
+      }
+    }
+    while (entities->size() > kept) {
+      entities->RemoveLast();
+    }
+  }
+  // then replace or append
+  std::unordered_map<int64_t, int> index;
+  index.reserve(entities->size());
+  for (int i = 0; i < entities->size(); i++) {
+    index[entities->Get(i).id()] = i;
+  }
+  for (const T& entity : changed) {
+    auto search = index.find(entity.id());
+    if (search == index.end()) {
+      entities->Add()->CopyFrom(entity);
+    } else {
+      entities->Mutable(search->second)->CopyFrom(entity);
+    }
+  }
+}
+
+}  // namespace
+
+void diffWorlds(const World& baseline, const World& current,
+                WorldDelta* delta) {
+  diff(baseline.players(), current.players(), delta->mutable_players(),
+       delta->mutable_removed_players());
+  diff(baseline.bullets(), current.bullets(), delta->mutable_bullets(),
+       delta->mutable_removed_bullets());
+  diff(baseline.explosions(), current.explosions(),
+       delta->mutable_explosions(), delta->mutable_removed_explosions());
+}
+
+void diffWorldEvents(const World& baseline, const World& current,
+                     const float elapsed, WorldDelta* delta) {
+  delta->set_particle_events(true);
+  delta->set_elapsed(elapsed);
+  diff(baseline.players(), current.players(), delta->mutable_players(),
+       delta->mutable_removed_players());
+  diffEvents(baseline.bullets(), current.bullets(), elapsed,
+             delta->mutable_bullets(), delta->mutable_removed_bullets());
+  diffEvents(baseline.explosions(), current.explosions(), elapsed,
+             delta->mutable_explosions(), delta->mutable_removed_explosions());
+}
+
+void applyDelta(const WorldDelta& delta, World* world) {
+  if (delta.particle_events()) {
+    extrapolate(delta.elapsed(), world->mutable_bullets());
+    extrapolate(delta.elapsed(), world->mutable_explosions());
+  }
+  apply(delta.players(), delta.removed_players(), world->mutable_players());
+  apply(delta.bullets(), delta.removed_bullets(), world->mutable_bullets());
+  apply(delta.explosions(), delta.removed_explosions(),
+        world->mutable_explosions());
+}
+
+}  // namespace spacefight
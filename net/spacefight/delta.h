@@ -0,0 +1,26 @@
+#ifndef NET_SPACEFIGHT_DELTA_H
+#define NET_SPACEFIGHT_DELTA_H
+
+#include "proto/spacefight/spacefight.pb.h"
+
+namespace spacefight {
+
+// compute the changes that turn a baseline world into the current world.
+// delta->baseline_tick is left for the caller to fill in.
+void diffWorlds(const World& baseline, const World& current, WorldDelta* delta);
+
+// compute the changes that turn a baseline world into the current world,
+// elapsed seconds later, sending bullets and explosions as events.
+// see WorldDelta.particle_events.
+void diffWorldEvents(const World& baseline, const World& current,
+                     const float elapsed, WorldDelta* delta);
+
+// apply changes to a world, turning a baseline world into the world the
+// delta was computed against. changed entities keep their position, new
+// entities are appended. bullets and explosions sent as events are moved
+// along, so they only match the current world to within rounding.
+void applyDelta(const WorldDelta& delta, World* world);
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,178 @@
+#include "net/spacefight/delta.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include "gtest/gtest.h"
+
+namespace spacefight {
+namespace {
+
+// a canonical form of a world that ignores entity order
+std::map<std::string, std::string> canonical(const World& world) {
+  std::map<std::string, std::string> out;
+  for (const Player& p : world.players()) {
+    out["p" + std::to_string(p.id())] = p.SerializeAsString();
+  }
+  for (const Bullet& b : world.bullets()) {
+    out["b" + std::to_string(b.id())] = b.SerializeAsString();
+  }
+  for (const Explosion& e : world.explosions()) {
+    out["e" + std::to_string(e.id())] = e.SerializeAsString();
+  }
+  return out;
+}
+
+void setBody(game::Body* body, float x, float y) {
+  body->mutable_phys()->mutable_pos()->set_x(x);
+  body->mutable_phys()->mutable_pos()->set_y(y);
+}
+
+TEST(DeltaTest, IdenticalWorldsAreEmpty) {
+  World world;
+  Player* player = world.add_players();
+  player->set_id(1);
+  setBody(player->mutable_ship()->mutable_body(), 1, 2);
+
+  WorldDelta delta;
+  diffWorlds(world, world, &delta);
+
+  EXPECT_EQ(0, delta.ByteSizeLong());
+}
+
+TEST(DeltaTest, AddedChangedAndRemoved) {
+  World before;
+  for (int id = 1; id <= 3; id++) {
+    Bullet* bullet = before.add_bullets();
+    bullet->set_id(id);
+    setBody(bullet->mutable_body(), id, id);
+  }
+  World after;
+  after.add_bullets()->CopyFrom(before.bullets(0));
+  after.add_bullets()->CopyFrom(before.bullets(1));
+  setBody(after.mutable_bullets(1)->mutable_body(), 20, 20);
+  after.add_bullets()->set_id(4);
+
+  WorldDelta delta;
+  diffWorlds(before, after, &delta);
+
+  ASSERT_EQ(2, delta.bullets_size());
+  EXPECT_EQ(2, delta.bullets(0).id());
+  EXPECT_EQ(4, delta.bullets(1).id());
+  ASSERT_EQ(1, delta.removed_bullets_size());
+  EXPECT_EQ(3, delta.removed_bullets(0));
+
+  applyDelta(delta, &before);
+  EXPECT_EQ(after.SerializeAsString(), before.SerializeAsString());
+}
+
+TEST(DeltaTest, RandomRoundTrips) {
+  std::mt19937 rng(99);
+  std::uniform_int_distribution<int> percent(0, 99);
+  int64_t next_id = 1;
+
+  World world;
+  for (int step = 0; step < 200; step++) {
+    World next;
+    // keep, move or drop existing entities and add some new ones
+    for (const Player& p : world.players()) {
+      int roll = percent(rng);
+      if (roll < 10) {
+        continue;
+      }
+      Player* copy = next.add_players();
+      copy->CopyFrom(p);
+      if (roll < 50) {
+        setBody(copy->mutable_ship()->mutable_body(), percent(rng), step);
+        copy->set_is_thrusting(roll % 2);
+      }
+    }
+    for (const Bullet& b : world.bullets()) {
+      if (percent(rng) < 20) {
+        continue;
+      }
+      Bullet* copy = next.add_bullets();
+      copy->CopyFrom(b);
+      copy->set_lifespan(b.lifespan() - 1);
+    }
+    for (int i = percent(rng) % 5; i > 0; i--) {
+      Player* player = next.add_players();
+      player->set_id(next_id++);
+      player->set_username("new");
+      Bullet* bullet = next.add_bullets();
+      bullet->set_id(next_id++);
+      bullet->set_player_id(player->id());
+      Explosion* explosion = next.add_explosions();
+      explosion->set_id(next_id++);
+    }
+
+    WorldDelta delta;
+    diffWorlds(world, next, &delta);
+    World rebuilt(world);
+    applyDelta(delta, &rebuilt);
+    ASSERT_EQ(canonical(next), canonical(rebuilt)) << "step " << step;
+
+    world.Swap(&next);
+  }
+}
+
+// a bullet moving along x at 4 units per second
+Bullet* addBullet(World* world, int64_t id, float x, float lifespan) {
+  Bullet* bullet = world->add_bullets();
+  bullet->set_id(id);
+  bullet->set_lifespan(lifespan);
+  setBody(bullet->mutable_body(), x, 0);
+  bullet->mutable_body()->mutable_phys()->mutable_vel()->set_x(4);
+  return bullet;
+}
+
+TEST(DeltaTest, ParticleEventsOnlySendSpawnsAndEarlyRemovals) {
+  World before;
+  addBullet(&before, 1, 0, 3);  // keeps moving
+  addBullet(&before, 2, 0, 3);  // hits something
+  addBullet(&before, 3, 0, 0.5);  // runs out of lifespan
+  World after;
+  addBullet(&after, 1, 2, 2.5);
+  addBullet(&after, 4, 9, 3);  // just fired
+
+  WorldDelta delta;
+  diffWorldEvents(before, after, 0.5, &delta);
+
+  EXPECT_TRUE(delta.particle_events());
+  EXPECT_EQ(0.5, delta.elapsed());
+  ASSERT_EQ(1, delta.bullets_size());
+  EXPECT_EQ(4, delta.bullets(0).id());
+  ASSERT_EQ(1, delta.removed_bullets_size());
+  EXPECT_EQ(2, delta.removed_bullets(0));
+
+  applyDelta(delta, &before);
+  EXPECT_EQ(after.SerializeAsString(), before.SerializeAsString());
+}
+
+TEST(DeltaTest, ParticleEventsAreSmaller) {
+  World before;
+  World after;
+  for (int id = 1; id <= 100; id++) {
+    addBullet(&before, id, id, 3);
+    addBullet(&after, id, id + 2, 2.5);
+  }
+
+  WorldDelta full;
+  diffWorlds(before, after, &full);
+  WorldDelta events;
+  diffWorldEvents(before, after, 0.5, &events);
+
+  EXPECT_EQ(100, full.bullets_size());
+  EXPECT_EQ(0, events.bullets_size());
+  EXPECT_LT(events.ByteSizeLong(), 16);
+  applyDelta(events, &before);
+  EXPECT_EQ(after.SerializeAsString(), before.SerializeAsString());
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,6 +1,7 @@
 #ifndef NET_SPACEFIGHT_SHIP_H
 #define NET_SPACEFIGHT_SHIP_H
 
+#include <chrono>
 #include "net/spacefight/maths.h"
 
 namespace spacefight {
@@ -8,6 +9,25 @@ namespace spacefight {
 namespace settings {
 static constexpr std::chrono::milliseconds world_update_interval(26);
 static constexpr std::chrono::milliseconds game_update_interval(26);
+// every step advances the world by the same amount of time, in seconds
+static constexpr float step_seconds =
+    std::chrono::duration<float>(game_update_interval).count();
+// most fixed steps run at once to catch up after a slow update
+static constexpr int max_catchup_steps = 4;
+// deflate each world snapshot once instead of compressing it per stream
+static constexpr bool compress_world = true;
+// send every client a full world at least this often, in game updates
+static constexpr int64_t keyframe_ticks = 128;
+// send a full world if a client has not acknowledged this many frames
+static constexpr size_t max_unacked_frames = 64;
+// only send clients the part of the world around their ship
+static constexpr bool filter_interest = true;
+// longest a stream waits for the next snapshot before checking it is open
+static constexpr std::chrono::milliseconds snapshot_wait(100);
+// the longest a client waits between frames, however slowly it takes them
+static constexpr std::chrono::milliseconds slowest_send_interval(208);
+// most queued players admitted into the game at the start of each step
+static constexpr size_t max_joins_per_step = 64;
 }  // namespace settings
 
 namespace world {
@@ -36,6 +56,30 @@ static constexpr float size = 50.0f;
 static constexpr float lifespan = 4;
 }  // namespace explosions
 
+namespace grid {
+// broad phase cell width, a ship will span at most 2x2 cells
+static constexpr float cell_size = 2 * ships::size;
+}  // namespace grid
+
+namespace interest {
+// clients receive every entity within this distance of their ship
+static constexpr float radius = 1500;
+// extra distance covered, so that entities do not pop in at the edge
+static constexpr float margin = 2 * ships::size;
+// players whose ships are in the same cell share one view of the world
+static constexpr float cell_size = 500;
+}  // namespace interest
+
+namespace compact {
+// fixed point steps for clients that negotiate CompactWorld frames.
+// a position inside the spawn radius fits in 13 bits.
+static constexpr float position_scale = world::spawn_radius / 4096;
+static constexpr float velocity_scale = 1.0f;
+static constexpr float lifespan_scale = 0.01f;
+// steps in one full turn of a rotation
+static constexpr int angle_steps = 256;
+}  // namespace compact
+
 }  // namespace spacefight
 
 #endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "net/spacefight/entities.h"
+
+#include <algorithm>
+#include "net/spacefight/kernels.h"
+
+namespace spacefight {
+
+// IdIndex {
+
+void IdIndex::set(const int64_t id, const size_t index) {
+  if (pages_.empty()) {
+    base_ = id;
+  } else if (id < base_) {
+    // an id older than any in use, so the table grows at the front
+    const size_t before = (base_ - id + kPageSize - 1) / kPageSize;
+    pages_.resize(pages_.size() + before);
+    std::rotate(pages_.rbegin(), pages_.rbegin() + before, pages_.rend());
+    base_ -= static_cast<int64_t>(before * kPageSize);
+  }
+  const uint64_t slot = id - base_;
+  const uint64_t page = slot / kPageSize;
+  if (page >= pages_.size()) {
+    pages_.resize(page + 1);
+  }
+  if (!pages_[page]) {
+    pages_[page].reset(new Page());
+    pages_used_++;
+  }
+  int32_t& entry = pages_[page]->index[slot % kPageSize];
+  if (entry == kMissing) {
+    pages_[page]->used++;
+    size_++;
+  }
+  entry = index;
+}
+
+void IdIndex::erase(const int64_t id) {
+  if (id < base_) {
+    return;
+  }
+  const uint64_t slot = id - base_;
+  const uint64_t page = slot / kPageSize;
+  if (page >= pages_.size() || !pages_[page]) {
+    return;
+  }
+  int32_t& entry = pages_[page]->index[slot % kPageSize];
+  if (entry == kMissing) {
+    return;
+  }
+  entry = kMissing;
+  size_--;
+  if (--pages_[page]->used > 0) {
+    return;
+  }
+  pages_[page].reset();
+  pages_used_--;
+  // rebase past the pages before the oldest id in use, and drop the pages
+  // after the newest
+  auto first = std::find_if(
+      pages_.begin(), pages_.end(),
+      [](const std::unique_ptr<Page>& held) { return held != nullptr; });
+  base_ += (first - pages_.begin()) * static_cast<int64_t>(kPageSize);
+  pages_.erase(pages_.begin(), first);
+  while (!pages_.empty() && !pages_.back()) {
+    pages_.pop_back();
+  }
+}
+
+// } IdIndex
+
+// Bodies {
+
+size_t Bodies::add() {
+  x.push_back(0);
+  y.push_back(0);
+  dx.push_back(0);
+  dy.push_back(0);
+  w.push_back(0);
+  h.push_back(0);
+  rx.push_back(0);
+  ry.push_back(0);
+  return size() - 1;
+}
+
+void Bodies::erase(const size_t i) {
+  eraseAt(&x, i);
+  eraseAt(&y, i);
+  eraseAt(&dx, i);
+  eraseAt(&dy, i);
+  eraseAt(&w, i);
+  eraseAt(&h, i);
+  eraseAt(&rx, i);
+  eraseAt(&ry, i);
+}
+
+void Bodies::update(const float dt, const size_t begin, const size_t end) {
+  phys::integrate(x.data() + begin, y.data() + begin, dx.data() + begin,
+                  dy.data() + begin, end - begin, dt);
+}
+
+void Bodies::toProto(const size_t i, game::Body* body) const {
+  game::Physics* physics = body->mutable_phys();
+  phys::set(physics->mutable_pos(), x[i], y[i]);
+  phys::set(physics->mutable_vel(), dx[i], dy[i]);
+  phys::set(body->mutable_size(), w[i], h[i]);
+  phys::set(body->mutable_rotation(), rx[i], ry[i]);
+}
+
+// } Bodies
+
+// Ships {
+
+size_t Ships::add(const int64_t player_id, const std::string& name,
+                  const int64_t aarrggbb) {
+  id.push_back(player_id);
+  username.push_back(name);
+  color.push_back(aarrggbb);
+  flags.push_back(0);
+  body.add();
+  controls.push_back(Controls{});
+  fire_delay.push_back(0);
+  new_countdown.push_back(0);
+  dead_countdown.push_back(0);
+  bot.push_back(false);
+  bot_time.push_back(0);
+  return size() - 1;
+}
+
+void Ships::erase(const size_t i) {
+  eraseAt(&id, i);
+  eraseAt(&username, i);
+  eraseAt(&color, i);
+  eraseAt(&flags, i);
+  body.erase(i);
+  eraseAt(&controls, i);
+  eraseAt(&fire_delay, i);
+  eraseAt(&new_countdown, i);
+  eraseAt(&dead_countdown, i);
+  eraseAt(&bot, i);
+  eraseAt(&bot_time, i);
+}
+
+void Ships::toProto(const size_t i, Player* player) const {
+  player->set_id(id[i]);
+  player->set_username(username[i]);
+  player->mutable_color()->set_aarrggbb(color[i]);
+  player->set_is_new(flags[i] & kNew);
+  player->set_is_dead(flags[i] & kDead);
+  player->set_is_thrusting(flags[i] & kThrusting);
+  body.toProto(i, player->mutable_ship()->mutable_body());
+}
+
+// } Ships
+
+// Particles {
+
+size_t Particles::add(const int64_t particle_id, const int64_t owner_id,
+                      const int64_t aarrggbb, const float life) {
+  id.push_back(particle_id);
+  player_id.push_back(owner_id);
+  color.push_back(aarrggbb);
+  lifespan.push_back(life);
+  body.add();
+  return size() - 1;
+}
+
+void Particles::erase(const size_t i) {
+  eraseAt(&id, i);
+  eraseAt(&player_id, i);
+  eraseAt(&color, i);
+  eraseAt(&lifespan, i);
+  body.erase(i);
+}
+
+// } Particles
+
+}  // namespace spacefight
@@ -0,0 +1,224 @@
+#ifndef NET_SPACEFIGHT_ENTITIES_H
+#define NET_SPACEFIGHT_ENTITIES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "net/spacefight/physics.h"
+#include "proto/spacefight/spacefight.pb.h"
+
+namespace spacefight {
+
+// Entity storage for the simulation.
+//
+// Every property of every entity lives in its own contiguous array, indexed
+// by the entity's position in its group. A phase that only touches positions
+// and velocities walks only those arrays. Protobuf messages are only produced
+// when a snapshot of the world is requested.
+//
+// Removing an entity moves the last entity of its group into its index, so
+// removal is constant time but does not preserve order. Loops that remove
+// while iterating must revisit the index they removed from.
+
+// remove an element from the middle of a vector in constant time, by moving
+// the last element into its place. the vector keeps its capacity, so storage
+// freed by one entity is reused by the next.
+template <typename T>
+inline void eraseAt(std::vector<T>* v, const size_t i) {
+  if (i + 1 != v->size()) {
+    (*v)[i] = std::move(v->back());
+  }
+  v->pop_back();
+}
+
+// IdIndex finds entities by id, for groups whose ids count up from one and
+// are never reused.
+//
+// Ids take a slot each in fixed size pages of a dense array, so looking one
+// up is two array reads however long the entity has lived. A page is freed
+// once every id in it is gone, and the table of pages is rebased past the
+// pages before the oldest id still in use, so long-lived ids stay in the
+// dense path while the storage for ids that came and went is reclaimed.
+class IdIndex {
+ public:
+  static constexpr int32_t kMissing = -1;
+  // ids in each page
+  static constexpr size_t kPageSize = 256;
+
+  IdIndex() : base_(0), size_(0), pages_used_(0) {}
+
+  // get the index of an id, or kMissing
+  int32_t find(const int64_t id) const {
+    if (id < base_) {
+      return kMissing;
+    }
+    const uint64_t slot = id - base_;
+    const uint64_t page = slot / kPageSize;
+    if (page >= pages_.size() || !pages_[page]) {
+      return kMissing;
+    }
+    return pages_[page]->index[slot % kPageSize];
+  }
+  void set(const int64_t id, const size_t index);
+  void erase(const int64_t id);
+
+  // get the number of ids in the index
+  size_t size() const { return size_; }
+  // get the number of slots in the pages held
+  size_t slots() const { return pages_used_ * kPageSize; }
+
+ private:
+  struct Page {
+    Page() : used(0) { std::fill(index, index + kPageSize, kMissing); }
+
+    int32_t index[kPageSize];
+    // ids in use in this page
+    size_t used;
+  };
+
+  // the id in the first slot of the first page, a multiple of kPageSize
+  int64_t base_;
+  // pages in order of their ids, null where every id is gone
+  std::vector<std::unique_ptr<Page>> pages_;
+  // ids in use
+  size_t size_;
+  // pages that are not null
+  size_t pages_used_;
+};
+
+// Bodies holds the kinematics of a group of entities.
+struct Bodies {
+  // position
+  std::vector<float> x;
+  std::vector<float> y;
+  // velocity
+  std::vector<float> dx;
+  std::vector<float> dy;
+  // size
+  std::vector<float> w;
+  std::vector<float> h;
+  // rotation
+  std::vector<float> rx;
+  std::vector<float> ry;
+
+  size_t size() const { return x.size(); }
+
+  // append a zeroed body, returning its index
+  size_t add();
+  // remove the body at an index, moving the last body into its place
+  void erase(const size_t i);
+
+  // move every body along its velocity for a given time interval
+  void update(const float dt) { update(dt, 0, size()); }
+  // move the bodies in [begin, end) along their velocity
+  void update(const float dt, const size_t begin, const size_t end);
+
+  // get the bounding box of a body as it will be in dt seconds
+  phys::AABB futureBounds(const size_t i, const float dt) const {
+    phys::AABB box;
+    box.x1 = x[i] + dx[i] * dt;
+    box.y1 = y[i] + dy[i] * dt;
+    box.x2 = box.x1 + w[i];
+    box.y2 = box.y1 + h[i];
+    return box;
+  }
+
+  // get the bounding box of a body
+  phys::AABB bounds(const size_t i) const {
+    return phys::AABB{x[i], y[i], x[i] + w[i], y[i] + h[i]};
+  }
+
+  // get the box a body passes through over the next dt seconds
+  phys::AABB sweptBounds(const size_t i, const float dt) const {
+    return phys::sweptBounds(bounds(i), dx[i] * dt, dy[i] * dt);
+  }
+
+  // write a body into its protobuf representation
+  void toProto(const size_t i, game::Body* body) const;
+};
+
+// Controls are the inputs a player is currently holding down.
+struct Controls {
+  bool rotate_left;
+  bool rotate_right;
+  bool thrust;
+  bool fire;
+};
+
+// Ships holds every player's ship and the state needed to simulate it.
+struct Ships {
+  enum Flag : uint8_t {
+    kNew = 1 << 0,
+    kDead = 1 << 1,
+    kThrusting = 1 << 2,
+  };
+
+  std::vector<int64_t> id;
+  std::vector<std::string> username;
+  std::vector<int64_t> color;
+  // Flag bits, as last published to clients
+  std::vector<uint8_t> flags;
+  Bodies body;
+  std::vector<Controls> controls;
+  std::vector<float> fire_delay;
+  // countdown for how long a player is new
+  std::vector<float> new_countdown;
+  // countdown until a player respawns
+  std::vector<float> dead_countdown;
+  // whether the ship is flown by the AI, and for how long it has been
+  std::vector<uint8_t> bot;
+  std::vector<float> bot_time;
+
+  size_t size() const { return id.size(); }
+
+  // append a ship, returning its index
+  size_t add(const int64_t player_id, const std::string& name,
+             const int64_t aarrggbb);
+  // remove the ship at an index, moving the last ship into its place
+  void erase(const size_t i);
+
+  bool isNew(const size_t i) const { return new_countdown[i] > 0; }
+  bool isDead(const size_t i) const { return dead_countdown[i] > 0; }
+  void setFlag(const size_t i, const Flag flag, const bool on) {
+    flags[i] = on ? (flags[i] | flag) : (flags[i] & ~flag);
+  }
+
+  // write a ship into its protobuf representation
+  void toProto(const size_t i, Player* player) const;
+};
+
+// Particles holds short-lived entities that drift until their lifespan runs
+// out, such as bullets and explosions.
+struct Particles {
+  std::vector<int64_t> id;
+  std::vector<int64_t> player_id;
+  std::vector<int64_t> color;
+  std::vector<float> lifespan;
+  Bodies body;
+
+  size_t size() const { return id.size(); }
+
+  // append a particle, returning its index
+  size_t add(const int64_t particle_id, const int64_t owner_id,
+             const int64_t aarrggbb, const float life);
+  // remove the particle at an index, moving the last particle into its place
+  void erase(const size_t i);
+
+  // write a particle into its protobuf representation.
+  // T is either a Bullet or an Explosion.
+  template <typename T>
+  void toProto(const size_t i, T* out) const {
+    out->set_id(id[i]);
+    out->set_player_id(player_id[i]);
+    out->set_lifespan(lifespan[i]);
+    out->mutable_color()->set_aarrggbb(color[i]);
+    body.toProto(i, out->mutable_body());
+  }
+};
+
+}  // namespace spacefight
+
+#endif
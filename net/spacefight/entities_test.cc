@@ -0,0 +1,157 @@
+#include "net/spacefight/entities.h"
+
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace spacefight {
+namespace {
+
+TEST(EntitiesTest, EraseMovesLastIntoPlace) {
+  std::vector<std::string> v = {"a", "b", "c", "d"};
+
+  eraseAt(&v, 1);
+  EXPECT_EQ(std::vector<std::string>({"a", "d", "c"}), v);
+
+  eraseAt(&v, 2);
+  EXPECT_EQ(std::vector<std::string>({"a", "d"}), v);
+}
+
+TEST(EntitiesTest, EraseKeepsCapacity) {
+  Particles bullets;
+  for (int i = 0; i < 100; i++) {
+    bullets.add(i, 1, 0, 1.0f);
+  }
+  size_t capacity = bullets.id.capacity();
+  while (bullets.size() > 0) {
+    bullets.erase(0);
+  }
+  EXPECT_EQ(capacity, bullets.id.capacity());
+  EXPECT_EQ(capacity, bullets.body.x.capacity());
+}
+
+TEST(EntitiesTest, EraseKeepsColumnsTogether) {
+  Particles bullets;
+  for (int i = 0; i < 5; i++) {
+    size_t b = bullets.add(i, 10 + i, 0, 1.0f);
+    bullets.body.x[b] = 100 * i;
+  }
+
+  bullets.erase(1);
+
+  ASSERT_EQ(4u, bullets.size());
+  EXPECT_EQ(4, bullets.id[1]);
+  EXPECT_EQ(14, bullets.player_id[1]);
+  EXPECT_EQ(400, bullets.body.x[1]);
+  EXPECT_EQ(4u, bullets.body.size());
+}
+
+TEST(EntitiesTest, ShipsEraseKeepsColumnsTogether) {
+  Ships ships;
+  ships.add(1, "one", 0);
+  ships.add(2, "two", 0);
+  ships.add(3, "three", 0);
+  ships.setFlag(2, Ships::kDead, true);
+
+  ships.erase(0);
+
+  ASSERT_EQ(2u, ships.size());
+  EXPECT_EQ(3, ships.id[0]);
+  EXPECT_EQ("three", ships.username[0]);
+  EXPECT_EQ(Ships::kDead, ships.flags[0]);
+}
+
+TEST(EntitiesTest, IdIndexFindsById) {
+  IdIndex index;
+  index.set(3, 0);
+  index.set(1, 1);
+
+  EXPECT_EQ(index.find(3), 0);
+  EXPECT_EQ(index.find(1), 1);
+  EXPECT_EQ(index.find(2), IdIndex::kMissing);
+  EXPECT_EQ(index.find(4), IdIndex::kMissing);
+  EXPECT_EQ(index.find(-1), IdIndex::kMissing);
+
+  index.erase(3);
+  index.set(1, 0);
+  EXPECT_EQ(index.find(3), IdIndex::kMissing);
+  EXPECT_EQ(index.find(1), 0);
+}
+
+TEST(EntitiesTest, IdIndexStaysBoundedWithChurn) {
+  IdIndex index;
+  // players that never leave
+  for (int64_t id = 1; id <= 4; id++) {
+    index.set(id, id - 1);
+  }
+  // many more that join and leave, a few at a time
+  int64_t next_id = 5;
+  for (int round = 0; round < 10000; round++) {
+    const int64_t first = next_id;
+    for (int i = 0; i < 8; i++) {
+      index.set(next_id++, 4 + i);
+    }
+    for (int64_t id = first; id < next_id; id++) {
+      index.erase(id);
+    }
+  }
+  EXPECT_EQ(index.size(), 4);
+  EXPECT_LT(index.slots(), 1024 + 8);
+  for (int64_t id = 1; id <= 4; id++) {
+    EXPECT_EQ(index.find(id), id - 1);
+  }
+  EXPECT_EQ(index.find(next_id - 1), IdIndex::kMissing);
+  EXPECT_EQ(index.find(next_id), IdIndex::kMissing);
+
+  // ids from before the compaction can still move and leave
+  index.set(2, 7);
+  EXPECT_EQ(index.find(2), 7);
+  index.erase(2);
+  EXPECT_EQ(index.find(2), IdIndex::kMissing);
+  EXPECT_EQ(index.size(), 3);
+  // and ids handed out before it can still join after it
+  index.set(5, 1);
+  EXPECT_EQ(index.find(5), 1);
+  EXPECT_EQ(index.size(), 4);
+}
+
+TEST(EntitiesTest, IdIndexKeepsSurvivorsDense) {
+  IdIndex index;
+  // every 1000th player stays, the rest join and leave
+  std::vector<int64_t> kept;
+  for (int64_t id = 1; id <= 100000; id++) {
+    index.set(id, 0);
+    if (id % 1000 == 1) {
+      kept.push_back(id);
+    } else {
+      index.erase(id);
+    }
+  }
+  ASSERT_EQ(index.size(), kept.size());
+  // only the pages holding survivors are left
+  EXPECT_EQ(index.slots(), kept.size() * IdIndex::kPageSize);
+  for (size_t i = 0; i < kept.size(); i++) {
+    index.set(kept[i], i);
+  }
+  for (size_t i = 0; i < kept.size(); i++) {
+    EXPECT_EQ(index.find(kept[i]), static_cast<int32_t>(i));
+  }
+
+  // once the oldest leave, the rest are still found
+  for (size_t i = 0; i < kept.size() / 2; i++) {
+    index.erase(kept[i]);
+  }
+  EXPECT_EQ(index.slots(), (kept.size() / 2) * IdIndex::kPageSize);
+  for (size_t i = kept.size() / 2; i < kept.size(); i++) {
+    EXPECT_EQ(index.find(kept[i]), static_cast<int32_t>(i));
+  }
+  EXPECT_EQ(index.find(kept[0]), IdIndex::kMissing);
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,11 +1,13 @@
 #include "net/spacefight/game.h"
 
 #include <unistd.h>
+#include <algorithm>
 #include <chrono>
 #include <mutex>
 #include "hoist/likely.h"
 #include "hoist/logging.h"
 #include "hoist/math.h"
+#include "hoist/sync/affinity.h"
 #include "net/spacefight/color.h"
 #include "net/spacefight/debug.h"
 #include "net/spacefight/elements.h"
@@ -13,9 +15,6 @@
 
 namespace spacefight {
 
-// forward decls
-void setRandomSpawnPosition(game::Vector* v);
-
 template <typename T>
 inline T max(T a, T b) {
   return a > b ? a : b;
@@ -26,13 +25,39 @@ inline T min(T a, T b) {
   return a < b ? a : b;
 }
 
-float nanosToSeconds(Hoist::nanos_t nanos) {
-  return static_cast<float>(nanos) / 1e9;
+static constexpr float kStepSeconds = settings::step_seconds;
+
+// fewest entities worth handing to another thread
+static constexpr size_t kMinChunk = 256;
+
+// Stopwatch measures wall time between laps, whatever clock the game runs on.
+class Stopwatch {
+ public:
+  Stopwatch() : last_(std::chrono::steady_clock::now()) {}
+
+  // get the time since the last lap, and start the next one
+  Hoist::nanos_t lap() {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = now - last_;
+    last_ = now;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+        .count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point last_;
+};
+
+void setControls(Controls* controls, const PlayerInput* const input) {
+  controls->rotate_left = input->rotate_left();
+  controls->rotate_right = input->rotate_right();
+  controls->thrust = input->thrust();
+  controls->fire = input->fire();
 }
 
 // Game {
 
-WRITE_LOCKED void Game::start() {
+WRITE_LOCKED void Game::start(const bool run_loop) {
   WriteLock write_lock(mutex_);
   DLOG("Game.start()");
   if (started_) {
@@ -40,77 +65,166 @@ WRITE_LOCKED void Game::start() {
     return;
   }
   started_ = true;
-  last_update_ = clock_->nanos();
+  scheduler_.reset(clock_->nanos());
+  if (!run_loop) {
+    return;
+  }
 
   update_thread_ = std::thread([this]() {
     DLOG("update loop started");
+    if (cpu_ != kAnyCpu) {
+      Hoist::Status pinned = pinThisThread(cpu_);
+      WLOG_IF(!pinned.ok(), "cannot pin update thread to cpu "
+                                << cpu_ << ": " << pinned);
+    }
     while (started_) {
       update();
-      std::this_thread::sleep_for(settings::game_update_interval);
+      // only this thread moves the deadline, so it is safe to read unlocked
+      Hoist::nanos_t wait = scheduler_.deadline() - clock_->nanos();
+      if (wait > 0) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+      }
     }
     DLOG("update loop ended");
   });
 }
 
 WRITE_LOCKED void Game::end() {
+  {
+    WriteLock write_lock(mutex_);
+    DLOG("Game.end()");
+    if (!started_) {
+      ELOG("not started");
+      return;
+    }
+    started_ = false;
+  }
+  // wake anything waiting for a snapshot, there will be no more
+  {
+    std::lock_guard<std::mutex> lock(epoch_mutex_);
+  }
+  epoch_.notify_all();
+  // the update thread takes the lock to finish its last update
+  if (update_thread_.joinable()) {
+    update_thread_.join();
+  }
+}
+
+WRITE_LOCKED void Game::pinUpdateThread(const int cpu) {
   WriteLock write_lock(mutex_);
-  DLOG("Game.end()");
-  if (!started_) {
-    ELOG("not started");
+  if (started_) {
+    ELOG("already started, cannot pin the update thread");
     return;
   }
-  started_ = false;
-  update_thread_.join();
+  cpu_ = cpu;
 }
 
-WRITE_LOCKED void Game::apply(const PlayerInput* const input) {
-  WriteLock write_lock(mutex_);
+LOCK_FREE void Game::apply(const PlayerInput* const input) {
   if (!started_) {
     ELOG("game not started, cannot apply");
     return;
   }
-  applyUnlocked(input);
+  Controls controls;
+  setControls(&controls, input);
+  inputs_.push(QueuedInput{input->token(), controls, input->quit()});
 }
 
-void Game::applyUnlocked(const PlayerInput* const input) {
-  // if player quit, remove player
-  if (input->quit()) {
-    onQuit(input);
+void Game::admitJoins() {
+  joins_.drain(&joining_);
+  if (joining_.empty()) {
     return;
   }
-  // update the input state
-  auto search = tokens_.find(input->token());
-  if (UNLIKELY(search == tokens_.end())) {
-    ELOG("missing player " << input->username());
-    return;
+  const size_t admitted =
+      std::min(joining_.size(), settings::max_joins_per_step);
+  for (size_t i = 0; i < admitted; i++) {
+    const QueuedJoin& join = joining_[i];
+    if (recorder_) {
+      Record record{Record::kJoin};
+      record.player_id = join.player_id;
+      record.token = join.token;
+      record.username = join.username;
+      record.controls = join.controls;
+      recorder_->write(record);
+    }
+    createNewPlayerUnlocked(join.player_id, join.token, join.username,
+                            join.controls);
   }
-  Player* player = search->second;
-  PlayerState& state = player_states_[player];
-  state.input.CopyFrom(*input);
+  joining_.erase(joining_.begin(), joining_.begin() + admitted);
+  // once per step rather than per player, logging takes a global lock
+  logNumPlayers();
+  DLOG_IF(!joining_.empty(), joining_.size() << " players waiting to join");
 }
 
-void Game::onQuit(const PlayerInput* const input) {
-  DLOG("token " << input->token() << " requesting quit");
-  auto search = tokens_.find(input->token());
-  if (search != tokens_.end()) {
-    Player* player = tokens_[input->token()];
-    ILOG("player " << player->username() << " quit.");
+void Game::applyInputs() {
+  inputs_.drain(&drained_);
+  for (const QueuedInput& input : drained_) {
+    // if player quit, remove player
+    if (input.quit) {
+      onQuit(input.token);
+      continue;
+    }
+    // update the input state
+    int64_t player_id;
+    if (UNLIKELY(!tokens_.find(input.token, &player_id))) {
+      // players waiting to join can already be sending input, which they
+      // join with, as clients only send controls again when they change
+      updateJoining(input);
+      continue;
+    }
+    ships_.controls[ship_index_.find(player_id)] = input.controls;
+    if (recorder_) {
+      Record record{Record::kInput};
+      record.player_id = player_id;
+      record.controls = input.controls;
+      recorder_->write(record);
+    }
+  }
+  drained_.clear();
+}
 
-    // remove player state
-    player_states_.erase(player);
+void Game::updateJoining(const QueuedInput& input) {
+  // their join was pushed before their input, but may have missed this
+  // step's drain
+  joins_.drain(&joining_);
+  for (QueuedJoin& join : joining_) {
+    if (join.token == input.token) {
+      join.controls = input.controls;
+      return;
+    }
+  }
+  DLOG("input for a player not in the game");
+}
+
+void Game::onQuit(const std::string& token) {
+  DLOG("token " << token << " requesting quit");
+  int64_t player_id;
+  if (tokens_.find(token, &player_id)) {
+    if (recorder_) {
+      Record record{Record::kQuit};
+      record.token = token;
+      recorder_->write(record);
+    }
+    size_t index = ship_index_.find(player_id);
+    ILOG("player " << ships_.username[index] << " quit.");
 
     // remove from tokens
-    tokens_.erase(input->token());
-
-    // finally remove from the world
-    for (int i = 0; i < world_.players_size(); i++) {
-      Player* other = world_.mutable_players(i);
-      if (player == other) {
-        world_.mutable_players()->DeleteSubrange(i, 1);
-        i--;
-        break;
-      }
+    tokens_.erase(token);
+    ship_index_.erase(player_id);
+
+    // finally remove from the world, the last ship takes its place
+    ships_.erase(index);
+    if (index < ships_.size()) {
+      ship_index_.set(ships_.id[index], index);
     }
+  } else {
+    // a player that quit before they were admitted never joins. their join
+    // was pushed before their quit, but may have missed this step's drain.
+    joins_.drain(&joining_);
+    joining_.erase(std::remove_if(joining_.begin(), joining_.end(),
+                                  [&token](const QueuedJoin& join) {
+                                    return join.token == token;
+                                  }),
+                   joining_.end());
   }
   logNumPlayers();
 }
@@ -121,52 +235,160 @@ WRITE_LOCKED int64_t Game::createNewPlayer(const PlayerInput* const input) {
     ELOG("game not started, cannot createNewPlayer");
     return -1;
   }
-  return createNewPlayerUnlocked(input)->id();
-}
-
-Player* Game::createNewPlayerUnlocked(const PlayerInput* const input) {
-  DLOG("new player " << input->username());
-  Player* player = world_.add_players();
-  Ship* ship = player->mutable_ship();
-  game::Body* body = ship->mutable_body();
-  game::Physics* physics = body->mutable_phys();
-  player->set_id(++player_id_);
-  player->set_username(input->username());
-  player->set_is_new(true);
-  int color = Hoist::RNG::rand<int>(36) * 10;
-  player->mutable_color()->set_aarrggbb(
-      hsv2int64(hsv{static_cast<double>(color), 1, 1}));
-  phys::set(body->mutable_size(), ships::size, ships::size);
-  phys::set(body->mutable_rotation(), physics->vel());
-  phys::reset(physics->mutable_vel());
-  setRandomSpawnPosition(physics->mutable_pos());
-
-  tokens_[input->token()] = player;
-
-  PlayerState& state = player_states_[player];
+  Controls controls;
+  setControls(&controls, input);
+  int64_t player_id = ++player_id_;
+  if (recorder_) {
+    Record record{Record::kJoin};
+    record.player_id = player_id;
+    record.token = input->token();
+    record.username = input->username();
+    record.controls = controls;
+    recorder_->write(record);
+  }
+  createNewPlayerUnlocked(player_id, input->token(), input->username(),
+                          controls);
+  logNumPlayers();
+  return player_id;
+}
+
+LOCK_FREE int64_t Game::join(const PlayerInput* const input) {
+  if (!started_) {
+    ELOG("game not started, cannot join");
+    return -1;
+  }
+  QueuedJoin join{++player_id_, input->token(), input->username()};
+  setControls(&join.controls, input);
+  const int64_t player_id = join.player_id;
+  joins_.push(std::move(join));
+  return player_id;
+}
+
+WRITE_LOCKED void Game::record(std::unique_ptr<Recorder> recorder) {
+  WriteLock write_lock(mutex_);
+  if (started_) {
+    ELOG("game already started, cannot record");
+    return;
+  }
+  recorder_ = std::move(recorder);
+  Record header{Record::kHeader};
+  header.seed = seed_;
+  header.bots = num_bots_;
+  recorder_->write(header);
+}
+
+WRITE_LOCKED void Game::replay(const Record& record) {
+  WriteLock write_lock(mutex_);
+  switch (record.type) {
+    case Record::kJoin:
+      createNewPlayerUnlocked(record.player_id, record.token, record.username,
+                              record.controls);
+      logNumPlayers();
+      break;
+    case Record::kInput: {
+      int32_t index = ship_index_.find(record.player_id);
+      if (index != IdIndex::kMissing) {
+        ships_.controls[index] = record.controls;
+      }
+      break;
+    }
+    case Record::kQuit:
+      onQuit(record.token);
+      break;
+    case Record::kStep:
+      step(record.dt);
+      break;
+    case Record::kPublish:
+      publishSnapshot();
+      break;
+    case Record::kHeader:
+    case Record::kEnd:
+      break;
+  }
+}
+
+void Game::createNewPlayerUnlocked(const int64_t player_id,
+                                   const std::string& token,
+                                   const std::string& username,
+                                   const Controls& controls) {
+  DLOG("new player " << username);
+  int color = rng_.rand<int>(36) * 10;
+  size_t i = ships_.add(player_id, username,
+                        hsv2int64(hsv{static_cast<double>(color), 1, 1}));
+  Bodies& body = ships_.body;
+  body.w[i] = ships::size;
+  body.h[i] = ships::size;
+  setRandomSpawnPosition(&body.x[i], &body.y[i]);
+  ships_.setFlag(i, Ships::kNew, true);
+
+  tokens_.set(token, player_id);
+  ship_index_.set(player_id, i);
+
   // save input for update()
-  state.input.CopyFrom(*input);
+  ships_.controls[i] = controls;
   // this is a new ship.
-  state.new_countdown = ships::new_invincibility_time;
-
-  logNumPlayers();
-  return player;
+  ships_.new_countdown[i] = ships::new_invincibility_time;
 }
 
 void Game::logNumPlayers() {
-  int numPlayers = world_.players_size();
+  int numPlayers = ships_.size();
   ILOG("There " << (numPlayers == 1 ? "is" : "are") << " now " << numPlayers
                 << " " << (numPlayers == 1 ? "player" : "players")
                 << " playing.");
 }
 
-READ_LOCKED void Game::getWorld(World* world) {
-  ReadLock read_lock(mutex_);
+LOCK_FREE std::shared_ptr<const Snapshot> Game::getSnapshot() const {
   if (!started_) {
-    ELOG("game not started, cannot getWorld");
-    return;
+    ELOG("game not started, cannot getSnapshot");
+    return nullptr;
   }
-  world->CopyFrom(world_);
+  return std::atomic_load(&snapshot_);
+}
+
+LOCK_FREE std::shared_ptr<const Snapshot> Game::waitForSnapshot(
+    const int64_t tick, const Hoist::nanos_t timeout) const {
+  {
+    std::unique_lock<std::mutex> lock(epoch_mutex_);
+    epoch_.wait_for(lock, std::chrono::nanoseconds(timeout), [this, tick]() {
+      return !started_ || std::atomic_load(&snapshot_)->tick > tick;
+    });
+  }
+  // waiting on a game that has ended is expected, not an error
+  if (!started_) {
+    return nullptr;
+  }
+  return std::atomic_load(&snapshot_);
+}
+
+void Game::publishSnapshot() {
+  Stopwatch stopwatch;
+  // built privately, then only ever shared as const
+  std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>(snapshot_bytes_);
+  next->tick = tick_;
+  next->compress = settings::compress_world;
+  World* world = &next->world;
+  for (size_t i = 0; i < ships_.size(); i++) {
+    ships_.toProto(i, world->add_players());
+  }
+  for (size_t i = 0; i < bullets_.size(); i++) {
+    bullets_.toProto(i, world->add_bullets());
+  }
+  for (size_t i = 0; i < explosions_.size(); i++) {
+    explosions_.toProto(i, world->add_explosions());
+  }
+  encodeFrame(tick_, *world, settings::compress_world, &next->frame);
+  snapshot_bytes_ = next->arena.SpaceUsed();
+  std::shared_ptr<const Snapshot> snapshot(std::move(next));
+  std::atomic_store(&snapshot_, snapshot);
+  {
+    // waiters check for a new snapshot under the lock, so none can miss it
+    std::lock_guard<std::mutex> lock(epoch_mutex_);
+  }
+  epoch_.notify_all();
+  if (recorder_) {
+    recorder_->write(Record{Record::kPublish});
+  }
+  stats_.put(TickStats::kSnapshot, stopwatch.lap());
 }
 
 WRITE_LOCKED void Game::update() {
@@ -176,213 +398,356 @@ WRITE_LOCKED void Game::update() {
     return;
   }
 
-  float dt = computeTimeDelta();
+  Stopwatch stopwatch;
+  int64_t dropped = scheduler_.dropped();
+  int steps = scheduler_.advance(clock_->nanos());
+  if (steps == 0) {
+    return;
+  }
+  DLOG_IF(steps > 1, "catching up " << steps << " steps");
+  WLOG_IF(scheduler_.dropped() > dropped,
+          "update overran, dropped " << scheduler_.dropped() - dropped
+                                     << " steps ("
+                                     << scheduler_.dropped() << " total)");
+  for (int i = 0; i < steps; i++) {
+    step(kStepSeconds);
+  }
+  publishSnapshot();
+  stats_.putTick(stopwatch.lap(), steps, scheduler_.dropped() - dropped);
+  stats_.putEntities(ships_.size(), bullets_.size(), explosions_.size());
+}
+
+WRITE_LOCKED void Game::setTickThreads(const int threads) {
+  WriteLock write_lock(mutex_);
+  pool_.reset(new WorkerPool(threads));
+  candidates_.resize(pool_->size());
+  ship_events_.resize(pool_->size());
+}
+
+WRITE_LOCKED void Game::setExhaustiveCollisions(const bool exhaustive) {
+  WriteLock write_lock(mutex_);
+  exhaustive_ = exhaustive;
+}
+
+WRITE_LOCKED std::vector<Game::Hit> Game::lastHits() const {
+  WriteLock write_lock(mutex_);
+  return last_hits_;
+}
+
+WRITE_LOCKED PhaseTimes Game::phaseTimes() const {
+  WriteLock write_lock(mutex_);
+  return stats_.totals();
+}
+
+void Game::step(float dt) {
+  tick_++;
+  Stopwatch stopwatch;
+  admitJoins();
+  applyInputs();
+  if (recorder_) {
+    Record record{Record::kStep};
+    record.dt = dt;
+    recorder_->write(record);
+  }
+  stats_.put(TickStats::kInputs, stopwatch.lap());
   updateBulletCollisions(dt);
+  stats_.put(TickStats::kBulletCollisions, stopwatch.lap());
   updateShips(dt);
+  stats_.put(TickStats::kShips, stopwatch.lap());
   updateBullets(dt);
+  stats_.put(TickStats::kBullets, stopwatch.lap());
   updateExplosions(dt);
+  stats_.put(TickStats::kExplosions, stopwatch.lap());
   updateAI(dt);
+  stats_.put(TickStats::kAI, stopwatch.lap());
 }
 
-float Game::computeTimeDelta() {
-  Hoist::nanos_t now = clock_->nanos();
-  float dt = nanosToSeconds(now - last_update_);
-  last_update_ = now;
-  return dt;
+int32_t Game::firstHit(const size_t bi, const float dt,
+                       std::vector<int>* candidates) const {
+  const Bodies& bullet = bullets_.body;
+  const Bodies& ship = ships_.body;
+  const phys::AABB bullet_box = bullet.bounds(bi);
+  const int64_t shooter_id = bullets_.player_id[bi];
+  // sweep both over the whole step, so a fast bullet cannot pass through a
+  // ship between two steps however long they are
+  candidates->clear();
+  if (UNLIKELY(exhaustive_)) {
+    for (size_t pi = 0; pi < ships_.size(); pi++) {
+      candidates->push_back(pi);
+    }
+  } else {
+    ship_grid_.query(bullet.sweptBounds(bi, dt), candidates);
+  }
+  int32_t first = kNoHit;
+  float first_toi = 0;
+  // candidates are in ascending order, so of the ships hit at the same time
+  // the one an exhaustive scan of the world would find first wins.
+  for (int pi : *candidates) {
+    // if player isn't "invincible" because they're dead or new
+    if (UNLIKELY(ships_.isNew(pi) || ships_.isDead(pi))) {
+      continue;
+    }
+    // if it isn't friendly fire and it collides with us...
+    if (UNLIKELY(shooter_id == ships_.id[pi])) {
+      continue;
+    }
+    float toi;
+    if (phys::sweep(bullet_box, bullet.dx[bi] * dt, bullet.dy[bi] * dt,
+                    ship.bounds(pi), ship.dx[pi] * dt, ship.dy[pi] * dt,
+                    &toi) &&
+        (first == kNoHit || toi < first_toi)) {
+      first = pi;
+      first_toi = toi;
+    }
+  }
+  return first;
 }
 
 void Game::updateBulletCollisions(float dt) {
-  for (int bi = 0; bi < world_.bullets_size(); bi++) {
-    const Bullet& bullet = world_.bullets(bi);
-    for (int pi = 0; pi < world_.players_size(); pi++) {
-      const Player& player = world_.players(pi);
-      PlayerState& state = player_states_[&player];
-      // if player isn't "invincible" because they're dead or new
-      if (UNLIKELY(state.isNew() || state.isDead())) {
-        continue;
-      }
-      // if it isn't friendly fire and it collides with us...
-      if (UNLIKELY(bullet.player_id() == player.id())) {
+  // broad phase: bucket every ship that can be hit by everywhere it will
+  // pass through this step
+  ship_grid_.clear();
+  for (size_t pi = 0; pi < ships_.size(); pi++) {
+    if (UNLIKELY(ships_.isNew(pi) || ships_.isDead(pi))) {
+      continue;
+    }
+    ship_grid_.insert(pi, ships_.body.sweptBounds(pi, dt));
+  }
+  ship_grid_.build();
+
+  // find what every bullet would hit if nothing died this step
+  const size_t num_bullets = bullets_.size();
+  hits_.resize(num_bullets);
+  pool_->parallelFor(num_bullets, kMinChunk,
+                     [this, dt](int chunk, size_t begin, size_t end) {
+                       std::vector<int>* candidates = &candidates_[chunk];
+                       for (size_t bi = begin; bi < end; bi++) {
+                         hits_[bi] = firstHit(bi, dt, candidates);
+                       }
+                     });
+
+  // apply the hits in order. erasing a bullet moves the last bullet into its
+  // place, so track where each bullet was when its hit was found.
+  hit_order_.resize(num_bullets);
+  for (size_t bi = 0; bi < num_bullets; bi++) {
+    hit_order_[bi] = bi;
+  }
+  last_hits_.clear();
+  for (size_t bi = 0; bi < bullets_.size(); bi++) {
+    int32_t pi = hits_[hit_order_[bi]];
+    if (LIKELY(pi == kNoHit)) {
+      continue;
+    }
+    // an earlier bullet killed the ship, so look again
+    if (UNLIKELY(ships_.isDead(pi))) {
+      pi = firstHit(bi, dt, &candidates_[0]);
+      if (pi == kNoHit) {
         continue;
       }
-      if (phys::willCollide(player.ship().body(), bullet.body(), dt)) {
-        for (int assailantIndex = 0; assailantIndex < world_.players_size();
-             assailantIndex++) {
-          const Player& assailant = world_.players(assailantIndex);
-          if (bullet.player_id() == assailant.id()) {
-            ILOG("player " << player.username() << " was shot by "
-                           << assailant.username() << '!');
-          }
-        }
-        // remove bullet
-        world_.mutable_bullets()->DeleteSubrange(bi, 1);
-        bi--;
-        // remove player temporarily
-        state.dead_countdown = ships::respawn_time;
-        // create explosion
-        const Ship& player_ship = player.ship();
-        const game::Body& player_body = player_ship.body();
-        const game::Physics& player_physics = player_body.phys();
-        Explosion* explosion = world_.add_explosions();
-        game::Body* explosion_body = explosion->mutable_body();
-        game::Physics* explosion_physics = explosion_body->mutable_phys();
-        explosion->set_id(++explosion_id_);
-        explosion->set_player_id(player.id());
-        explosion->set_lifespan(explosions::lifespan);
-        explosion->mutable_color()->CopyFrom(player.color());
-        // set centered at player position
-        phys::set(explosion_physics->mutable_pos(),
-                  player_physics.pos().x() + player_body.size().x() * 0.5 -
-                      explosions::size * 0.5,
-                  player_physics.pos().y() + player_body.size().y() * 0.5 -
-                      explosions::size * 0.5);
-        // set velocity..
-        phys::set(explosion_physics->mutable_vel(), player_physics.vel());
-        // Bullet body
-        phys::set(explosion_body->mutable_size(), explosions::size,
-                  explosions::size);
-        phys::set(explosion_body->mutable_rotation(), explosion_physics->vel());
-        // stop this bullet loop
-        break;
-      }
     }
+    int32_t assailant = ship_index_.find(bullets_.player_id[bi]);
+    if (assailant != IdIndex::kMissing) {
+      ILOG("player " << ships_.username[pi] << " was shot by "
+                     << ships_.username[assailant] << '!');
+    }
+    last_hits_.push_back(
+        Hit{bullets_.id[bi], bullets_.player_id[bi], ships_.id[pi]});
+    // remove bullet, the last bullet moves here and is checked next
+    bullets_.erase(bi);
+    eraseAt(&hit_order_, bi);
+    bi--;
+    // remove player temporarily
+    ships_.dead_countdown[pi] = ships::respawn_time;
+    spawnExplosion(pi);
   }
 }
 
 void Game::updateShips(float dt) {
-  for (int pi = 0; pi < world_.players_size(); pi++) {
-    Player* player = world_.mutable_players(pi);
-    Ship* ship = player->mutable_ship();
-    game::Body* body = ship->mutable_body();
-    game::Physics* physics = body->mutable_phys();
-    PlayerState& state = player_states_[player];
-    if (!state.isDead()) {
-      // INPUT
-      player->set_is_thrusting(state.input.thrust());
-      if (state.input.thrust()) {
-        game::Vector v;
-        phys::set(&v, ships::thrust * dt, 0);
-        phys::rotate(&v, phys::angle(body->rotation()));
-        phys::add(physics->mutable_vel(), &v);
-        phys::set(body->mutable_rotation(), physics->vel());
+  // ships only change themselves, so they are simulated in parallel. what
+  // they spawn, and respawning, which is random, is applied afterwards in
+  // order of the ships, as if they had been simulated one by one.
+  // every turning ship turns by the same angle, so it is found once
+  const phys::Rotation turn = phys::rotation(ships::rotate_speed * dt);
+  pool_->parallelFor(ships_.size(), kMinChunk,
+                     [this, dt, &turn](int chunk, size_t begin, size_t end) {
+                       std::vector<ShipEvent>* events = &ship_events_[chunk];
+                       for (size_t i = begin; i < end; i++) {
+                         updateShip(i, dt, turn, events);
+                       }
+                     });
+  Bodies& body = ships_.body;
+  for (int chunk = 0; chunk < pool_->size(); chunk++) {
+    for (const ShipEvent& event : ship_events_[chunk]) {
+      if (event.fired) {
+        spawnBullet(event.ship);
       } else {
-        phys::reset(physics->mutable_vel());
-      }
-      if (state.input.rotate_left()) {
-        phys::rotate(physics->mutable_vel(), -ships::rotate_speed * dt);
-        phys::rotate(body->mutable_rotation(), -ships::rotate_speed * dt);
-      } else if (state.input.rotate_right()) {
-        phys::rotate(physics->mutable_vel(), ships::rotate_speed * dt);
-        phys::rotate(body->mutable_rotation(), ships::rotate_speed * dt);
+        setRandomSpawnPosition(&body.x[event.ship], &body.y[event.ship]);
+        phys::rotate(&body.rx[event.ship], &body.ry[event.ship],
+                     rng_.rand<float>(0, degToRad(360)));
       }
-      phys::update(physics, dt);
-      phys::clampMagnitude(physics->mutable_vel(), ships::max_vel);
-      // fire bullets
-      state.fire_delay -= dt;
-      if (state.input.fire() && state.fire_delay <= 0) {
-        state.fire_delay = ships::fire_rate;
-        Bullet* bullet = world_.add_bullets();
-        game::Body* bullet_body = bullet->mutable_body();
-        game::Physics* bullet_physics = bullet_body->mutable_phys();
-        bullet->set_id(++bullet_id_);
-        bullet->set_player_id(player->id());
-        bullet->set_lifespan(bullets::lifespan);
-        bullet->mutable_color()->CopyFrom(player->color());
-        // set centered at player position
-        phys::set(
-            bullet_physics->mutable_pos(),
-            physics->pos().x() + body->size().x() * 0.5 - bullets::size * 0.5,
-            physics->pos().y() + body->size().y() * 0.5 - bullets::size * 0.5);
-        // set velocity..
-        phys::set(bullet_physics->mutable_vel(), bullets::vel, 0);
-        // ..angled to face the same direction as the player
-        phys::rotate(bullet_physics->mutable_vel(),
-                     phys::angle(body->rotation()));
-        // ..plus the ships velocity
-        phys::add(bullet_physics->mutable_vel(), physics->mutable_vel());
-        // Bullet body
-        phys::set(bullet_body->mutable_size(), bullets::size, bullets::size);
-        phys::set(bullet_body->mutable_rotation(), bullet_physics->vel());
-      }
-    }
-    // STATE
-    bool wasNew = state.isNew();
-    bool wasDead = state.isDead();
-    state.update(dt);
-    bool isDead = state.isDead();
-    player->set_is_dead(isDead);
-    // if we came alive magically
-    if (wasDead && !isDead) {
-      // we are invincible for some time
-      state.new_countdown = ships::new_invincibility_time;
     }
-    bool isNew = state.isNew();
-    if (!wasNew && isNew) {
-      setRandomSpawnPosition(physics->mutable_pos());
-      phys::rotate(body->mutable_rotation(),
-                   Hoist::RNG::rand<float>(0, degToRad(360)));
-    }
-    player->set_is_new(isNew);
+    // the next step may use fewer chunks
+    ship_events_[chunk].clear();
   }
 }
 
-void Game::updateBullets(float dt) {
-  for (int i = 0; i < world_.bullets_size(); i++) {
-    Bullet* bullet = world_.mutable_bullets(i);
-    // remove long-lived bullets
-    bullet->set_lifespan(bullet->lifespan() - dt);
-    if (bullet->lifespan() <= 0) {
-      world_.mutable_bullets()->DeleteSubrange(i, 1);
-      i--;
-      continue;
+void Game::updateShip(const size_t i, const float dt,
+                      const phys::Rotation& turn,
+                      std::vector<ShipEvent>* events) {
+  Bodies& body = ships_.body;
+  if (!ships_.isDead(i)) {
+    // INPUT
+    const Controls& input = ships_.controls[i];
+    ships_.setFlag(i, Ships::kThrusting, input.thrust);
+    if (input.thrust) {
+      // thrust along the way the ship faces
+      float ux, uy;
+      phys::direction(body.rx[i], body.ry[i], &ux, &uy);
+      body.dx[i] += ux * ships::thrust * dt;
+      body.dy[i] += uy * ships::thrust * dt;
+      body.rx[i] = body.dx[i];
+      body.ry[i] = body.dy[i];
+    } else {
+      body.dx[i] = 0;
+      body.dy[i] = 0;
+    }
+    if (input.rotate_left || input.rotate_right) {
+      const phys::Rotation r = input.rotate_left ? phys::inverse(turn) : turn;
+      phys::rotate(&body.dx[i], &body.dy[i], r);
+      phys::rotate(&body.rx[i], &body.ry[i], r);
     }
-    // update bullet
-    phys::update(bullet->mutable_body(), dt);
+    body.x[i] += body.dx[i] * dt;
+    body.y[i] += body.dy[i] * dt;
+    phys::clampMagnitude(&body.dx[i], &body.dy[i], ships::max_vel);
+    // fire bullets
+    ships_.fire_delay[i] -= dt;
+    if (input.fire && ships_.fire_delay[i] <= 0) {
+      ships_.fire_delay[i] = ships::fire_rate;
+      events->push_back(ShipEvent{static_cast<uint32_t>(i), true});
+    }
+  }
+  // STATE
+  bool wasNew = ships_.isNew(i);
+  bool wasDead = ships_.isDead(i);
+  ships_.new_countdown[i] -= dt;
+  ships_.dead_countdown[i] -= dt;
+  bool isDead = ships_.isDead(i);
+  ships_.setFlag(i, Ships::kDead, isDead);
+  // if we came alive magically
+  if (wasDead && !isDead) {
+    // we are invincible for some time
+    ships_.new_countdown[i] = ships::new_invincibility_time;
   }
+  bool isNew = ships_.isNew(i);
+  if (!wasNew && isNew) {
+    events->push_back(ShipEvent{static_cast<uint32_t>(i), false});
+  }
+  ships_.setFlag(i, Ships::kNew, isNew);
 }
 
-void Game::updateExplosions(float dt) {
-  for (int i = 0; i < world_.explosions_size(); i++) {
-    Explosion* explosion = world_.mutable_explosions(i);
-    // remove long-lived explosions
-    explosion->set_lifespan(explosion->lifespan() - dt);
-    if (explosion->lifespan() <= 0) {
-      world_.mutable_explosions()->DeleteSubrange(i, 1);
+void Game::updateParticles(Particles* particles, float dt) {
+  Bodies& body = particles->body;
+  std::vector<float>& lifespan = particles->lifespan;
+  pool_->parallelFor(lifespan.size(), kMinChunk,
+                     [&lifespan, dt](int chunk, size_t begin, size_t end) {
+                       for (size_t i = begin; i < end; i++) {
+                         lifespan[i] -= dt;
+                       }
+                     });
+  // remove long-lived particles
+  for (size_t i = 0; i < particles->size(); i++) {
+    if (lifespan[i] <= 0) {
+      particles->erase(i);
       i--;
-      continue;
     }
-    // update explosion
-    phys::update(explosion->mutable_body(), dt);
   }
+  pool_->parallelFor(body.size(), kMinChunk,
+                     [&body, dt](int chunk, size_t begin, size_t end) {
+                       body.update(dt, begin, end);
+                     });
 }
 
-void setRandomSpawnPosition(game::Vector* v) {
-  phys::set(v, Hoist::RNG::roll() * world::spawn_radius, 0);
-  phys::rotate(v, Hoist::RNG::roll() * 2 * M_PI);
+void Game::updateBullets(float dt) { updateParticles(&bullets_, dt); }
+
+void Game::updateExplosions(float dt) { updateParticles(&explosions_, dt); }
+
+void Game::spawnBullet(size_t ship) {
+  const Bodies& body = ships_.body;
+  size_t i = bullets_.add(++bullet_id_, ships_.id[ship], ships_.color[ship],
+                          bullets::lifespan);
+  Bodies& bullet = bullets_.body;
+  // set centered at player position
+  bullet.x[i] = body.x[ship] + body.w[ship] * 0.5 - bullets::size * 0.5;
+  bullet.y[i] = body.y[ship] + body.h[ship] * 0.5 - bullets::size * 0.5;
+  // set velocity..
+  // ..facing the same direction as the player
+  phys::direction(body.rx[ship], body.ry[ship], &bullet.dx[i], &bullet.dy[i]);
+  bullet.dx[i] *= bullets::vel;
+  bullet.dy[i] *= bullets::vel;
+  // ..plus the ships velocity
+  bullet.dx[i] += body.dx[ship];
+  bullet.dy[i] += body.dy[ship];
+  // Bullet body
+  bullet.w[i] = bullets::size;
+  bullet.h[i] = bullets::size;
+  bullet.rx[i] = bullet.dx[i];
+  bullet.ry[i] = bullet.dy[i];
 }
 
-void Game::createNewAI(const PlayerInput* const input) {
-  DLOG("AI entered the game. username=" << input->username()
-                                        << " token=" << input->token());
-  Player* bot = createNewPlayerUnlocked(input);
-  bots_.push_back(bot);
+void Game::spawnExplosion(size_t ship) {
+  const Bodies& body = ships_.body;
+  size_t i = explosions_.add(++explosion_id_, ships_.id[ship],
+                             ships_.color[ship], explosions::lifespan);
+  Bodies& explosion = explosions_.body;
+  // set centered at player position
+  explosion.x[i] = body.x[ship] + body.w[ship] * 0.5 - explosions::size * 0.5;
+  explosion.y[i] = body.y[ship] + body.h[ship] * 0.5 - explosions::size * 0.5;
+  // set velocity..
+  explosion.dx[i] = body.dx[ship];
+  explosion.dy[i] = body.dy[ship];
+  // Explosion body
+  explosion.w[i] = explosions::size;
+  explosion.h[i] = explosions::size;
+  explosion.rx[i] = explosion.dx[i];
+  explosion.ry[i] = explosion.dy[i];
 }
 
-void Game::updateAI(float dt) {
-  for (const Player* player : bots_) {
-    PlayerState& ps = player_states_[player];
-    BotState& bs = bot_states_[player];
+void Game::setRandomSpawnPosition(float* x, float* y) {
+  *x = rng_.roll() * world::spawn_radius;
+  *y = 0;
+  phys::rotate(x, y, rng_.roll() * 2 * M_PI);
+}
+
+void Game::createNewAI(const std::string& token, const std::string& username) {
+  DLOG("AI entered the game. username=" << username << " token=" << token);
+  int64_t bot = ++player_id_;
+  createNewPlayerUnlocked(bot, token, username, Controls{});
+  ships_.bot[ship_index_.find(bot)] = true;
+  logNumPlayers();
+}
 
-    bs.time += dt;
-    int seconds = static_cast<int>(bs.time);
+void Game::updateAI(float dt) {
+  pool_->parallelFor(ships_.size(), kMinChunk,
+                     [this, dt](int chunk, size_t begin, size_t end) {
+                       for (size_t i = begin; i < end; i++) {
+                         updateBot(i, dt);
+                       }
+                     });
+}
 
-    PlayerInput& input = ps.input;
-    input.set_fire(seconds % 5 == 0);
-    input.set_thrust(seconds % 3 == 0);
-    bool left = seconds % 4 == 0;
-    input.set_rotate_left(left);
-    input.set_rotate_right(!left);
+void Game::updateBot(const size_t i, const float dt) {
+  if (!ships_.bot[i]) {
+    return;
   }
+  ships_.bot_time[i] += dt;
+  int seconds = static_cast<int>(ships_.bot_time[i]);
+
+  Controls& input = ships_.controls[i];
+  input.fire = seconds % 5 == 0;
+  input.thrust = seconds % 3 == 0;
+  bool left = seconds % 4 == 0;
+  input.rotate_left = left;
+  input.rotate_right = !left;
 }
 
 // } Game
@@ -1,108 +1,258 @@
 #ifndef NET_SPACEFIGHT_GAME_H
 #define NET_SPACEFIGHT_GAME_H
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <thread>
-#include <unordered_map>
 #include "hoist/clock.h"
+#include "hoist/math.h"
+#include "hoist/sync/mpsc_queue.h"
+#include "hoist/sync/worker_pool.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/entities.h"
+#include "net/spacefight/grid.h"
+#include "net/spacefight/recording.h"
+#include "net/spacefight/scheduler.h"
+#include "net/spacefight/snapshot.h"
+#include "net/spacefight/tick_stats.h"
+#include "net/spacefight/token_map.h"
 #include "proto/spacefight/spacefight.pb.h"
 
 namespace spacefight {
 
 #define WRITE_LOCKED
-#define READ_LOCKED
+#define LOCK_FREE
 
 class Game final {
  public:
   Game() : Game(std::make_shared<Hoist::SystemClock>()) {}
-  Game(std::shared_ptr<Hoist::Clock> clock, const int numBots = 4)
+  // games created with the same seed and number of bots play out the same
+  // way given the same input
+  Game(std::shared_ptr<Hoist::Clock> clock, const int numBots = 4,
+       const uint64_t seed = Hoist::Random::randomSeed())
       : clock_(clock),
-        last_update_(0),
+        seed_(seed),
+        num_bots_(numBots),
+        rng_(seed),
+        pool_(new WorkerPool(1)),
+        ship_grid_(grid::cell_size),
+        exhaustive_(false),
+        candidates_(1),
+        ship_events_(1),
+        snapshot_bytes_(0),
+        scheduler_(std::chrono::nanoseconds(settings::game_update_interval)
+                       .count(),
+                   settings::max_catchup_steps),
+        stats_(std::chrono::nanoseconds(settings::game_update_interval)
+                   .count()),
+        tick_(0),
         started_(false),
         bullet_id_(0),
         player_id_(0),
-        explosion_id_(0) {
+        explosion_id_(0),
+        cpu_(kAnyCpu) {
     for (int i = 0; i < numBots; i++) {
       std::string name("gunther");
       name.append(std::to_string(i));
       std::string token("token");
       token.append(std::to_string(i));
-      PlayerInput* leaked_input = new PlayerInput();
-      leaked_input->set_username(name);
-      leaked_input->set_token(token);
-      createNewAI(leaked_input);
+      createNewAI(token, name);
     }
+    publishSnapshot();
   }
 
   Game(const Game&) = delete;
   Game& operator=(const Game&) = delete;
 
-  WRITE_LOCKED void start();
+  // Start the game. Unless run_loop is false, a thread runs update() on
+  // every tick, otherwise the caller drives updates itself, such as a test
+  // or benchmark with a manual clock.
+  WRITE_LOCKED void start(const bool run_loop = true);
   WRITE_LOCKED void end();
 
+  // Run the update thread only on one cpu, see pinThisThread().
+  // Must be called before the game starts.
+  WRITE_LOCKED void pinUpdateThread(const int cpu);
+
+  // Add a player to the game straight away, returning their id.
   WRITE_LOCKED int64_t createNewPlayer(const PlayerInput* const input);
+  // Queue a player to join at the start of a coming step, without taking any
+  // lock, and return the id they will have. Each step admits at most
+  // settings::max_joins_per_step queued players, oldest first, so a burst of
+  // logins is spread over several steps instead of stalling one.
+  LOCK_FREE int64_t join(const PlayerInput* const input);
+
+  // Record everything that changes the game from now on.
+  // Must be called before the game starts.
+  WRITE_LOCKED void record(std::unique_ptr<Recorder> recorder);
+  // Apply a record from a recording of a game with the same seed and bots.
+  // Start the game without its update thread before replaying.
+  WRITE_LOCKED void replay(const Record& record);
 
-  WRITE_LOCKED void apply(const PlayerInput* const input);
-  READ_LOCKED void getWorld(World* world);
+  // Queue input for the next update, without taking any lock.
+  LOCK_FREE void apply(const PlayerInput* const input);
+  // Get the world as of the most recent update.
+  // Snapshots are immutable and remain valid after later updates.
+  LOCK_FREE std::shared_ptr<const Snapshot> getSnapshot() const;
+  // Wait up to timeout nanoseconds for a snapshot newer than a tick, so
+  // every snapshot can be sent as soon as it is published.
+  // Returns the newest snapshot, which is no newer than tick if the wait
+  // timed out, or null once the game has ended.
+  LOCK_FREE std::shared_ptr<const Snapshot> waitForSnapshot(
+      const int64_t tick, const Hoist::nanos_t timeout) const;
 
+  // run every fixed step that is due on the clock, then publish a snapshot
   WRITE_LOCKED void update();
 
+  // Split the work of each step across a number of threads.
+  // The game plays out the same way for any number of threads.
+  WRITE_LOCKED void setTickThreads(const int threads);
+
+  // a bullet that hit a ship
+  struct Hit {
+    int64_t bullet_id;
+    // the player who fired the bullet, and the player it hit
+    int64_t shooter_id;
+    int64_t victim_id;
+  };
+  // Check every bullet against every ship, rather than only the ships the
+  // grid puts near it. The hits are exactly the same, found more slowly, so
+  // this is only for checking the grid against.
+  WRITE_LOCKED void setExhaustiveCollisions(const bool exhaustive);
+  // get the hits of the most recent step, in the order they were applied
+  WRITE_LOCKED std::vector<Hit> lastHits() const;
+
+  // get how long each phase of the update has taken so far
+  WRITE_LOCKED PhaseTimes phaseTimes() const;
+  // get statistics about recent updates, which are safe to read at any time
+  LOCK_FREE const TickStats& tickStats() const { return stats_; }
+
  private:
-  struct PlayerState {
-    PlayerInput input;
-    float fire_delay;
-    // countdown for how long a player is new
-    float new_countdown;
-    // countdown until a player respawns
-    float dead_countdown;
-
-    bool isNew() { return new_countdown > 0; }
-    bool isDead() { return dead_countdown > 0; }
-    void update(float dt) {
-      new_countdown -= dt;
-      dead_countdown -= dt;
-    }
+  // a bullet that hits no ship
+  static constexpr int32_t kNoHit = -1;
+  // something a ship did while ships were simulated in parallel
+  struct ShipEvent {
+    uint32_t ship;
+    // whether it fired, otherwise it respawned
+    bool fired;
+  };
+  // a player waiting to join
+  struct QueuedJoin {
+    int64_t player_id;
+    std::string token;
+    std::string username;
+    Controls controls;
   };
-  struct BotState {
-    float time;
+  // input waiting for the next update
+  struct QueuedInput {
+    std::string token;
+    Controls controls;
+    bool quit;
   };
   typedef std::unique_lock<std::shared_timed_mutex> WriteLock;
-  typedef std::shared_lock<std::shared_timed_mutex> ReadLock;
   mutable std::shared_timed_mutex mutex_;
   std::shared_ptr<Hoist::Clock> clock_;
-  World world_;
-  std::unordered_map<std::string, Player*> tokens_;
-  std::unordered_map<Player const*, PlayerState> player_states_;
-  std::unordered_map<Player const*, BotState> bot_states_;
-  std::vector<Player*> bots_;
-  Hoist::nanos_t last_update_;
-  bool started_;
+  const uint64_t seed_;
+  const int num_bots_;
+  // every random decision in the simulation, so that it can be replayed
+  Hoist::Random rng_;
+  // null unless recording
+  std::unique_ptr<Recorder> recorder_;
+  // simulation state
+  Ships ships_;
+  Particles bullets_;
+  Particles explosions_;
+  // player id to index into ships_
+  IdIndex ship_index_;
+  // token to player id
+  TokenMap tokens_;
+  // input from every stream, drained at the start of every step
+  MpscQueue<QueuedInput> inputs_;
+  std::vector<QueuedInput> drained_;
+  // players from join(), drained into joining_ until they are admitted
+  MpscQueue<QueuedJoin> joins_;
+  std::vector<QueuedJoin> joining_;
+  // splits each phase of a step across threads
+  std::unique_ptr<WorkerPool> pool_;
+  // broad phase for bullet collisions, rebuilt every update
+  SpatialGrid ship_grid_;
+  // check every ship instead of the grid
+  bool exhaustive_;
+  // per chunk of a phase
+  std::vector<std::vector<int>> candidates_;
+  std::vector<std::vector<ShipEvent>> ship_events_;
+  // ship each bullet would hit, or kNoHit
+  std::vector<int32_t> hits_;
+  // where each bullet was when hits_ was found
+  std::vector<uint32_t> hit_order_;
+  // hits applied in the most recent step
+  std::vector<Hit> last_hits_;
+  // latest published world, only accessed with std::atomic_load/atomic_store
+  std::shared_ptr<const Snapshot> snapshot_;
+  // signalled whenever a snapshot is published, or the game ends
+  mutable std::mutex epoch_mutex_;
+  mutable std::condition_variable epoch_;
+  // arena bytes the last snapshot used, to size the next one
+  size_t snapshot_bytes_;
+  TickScheduler scheduler_;
+  TickStats stats_;
+  int64_t tick_;
+  std::atomic<bool> started_;
   int64_t bullet_id_;
-  int64_t player_id_;
+  // the last player id handed out, by join() on any thread or by a step
+  std::atomic<int64_t> player_id_;
   int64_t explosion_id_;
   std::thread update_thread_;
+  // cpu the update thread is pinned to, or kAnyCpu
+  static constexpr int kAnyCpu = -1;
+  int cpu_;
 
   // Status
   void logNumPlayers();
 
   // Input sequence
-  void onQuit(const PlayerInput* const input);
+  void admitJoins();
+  void applyInputs();
+  // give a player waiting to join the controls they last sent
+  void updateJoining(const QueuedInput& input);
+  void onQuit(const std::string& token);
 
-  void createNewAI(const PlayerInput* const input);
-  Player* createNewPlayerUnlocked(const PlayerInput* const input);
-  void applyUnlocked(const PlayerInput* const input);
+  void createNewAI(const std::string& token, const std::string& username);
+  void createNewPlayerUnlocked(const int64_t player_id,
+                               const std::string& token,
+                               const std::string& username,
+                               const Controls& controls);
 
   // Update sequence
-  float computeTimeDelta();
+  void step(float dt);
   void updateBulletCollisions(float dt);
   void updateShips(float dt);
   void updateBullets(float dt);
   void updateExplosions(float dt);
+  // get the ship a bullet touches first during the next dt seconds, or kNoHit
+  int32_t firstHit(const size_t bi, const float dt,
+                   std::vector<int>* candidates) const;
+  // turn is the rotation of a ship turning right for dt
+  void updateShip(const size_t i, const float dt, const phys::Rotation& turn,
+                  std::vector<ShipEvent>* events);
+  void updateParticles(Particles* particles, float dt);
 
   // AI
   void updateAI(float dt);
+  void updateBot(const size_t i, const float dt);
+
+  // Snapshots
+  void publishSnapshot();
+
+  // Entity helpers
+  void setRandomSpawnPosition(float* x, float* y);
+  void spawnBullet(size_t ship);
+  void spawnExplosion(size_t ship);
 };
 
 }  // namespace spacefight
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,174 @@
+#include "net/spacefight/game.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include "benchmark/benchmark.h"
+#include "hoist/clock.h"
+#include "net/spacefight/elements.h"
+#include "proto/spacefight/spacefight.pb.h"
+
+namespace spacefight {
+namespace {
+
+static constexpr Hoist::nanos_t kTick =
+    std::chrono::nanoseconds(settings::game_update_interval).count();
+
+// ticks to run before measuring, so bullets and explosions build up
+static constexpr int kWarmupTicks = 256;
+
+// Runs the game loop headless, one tick per iteration, without sleeping.
+//
+// Arguments are the number of players, the number of bots, the percent of
+// players holding down fire, which sets how many bullets are in flight, and
+// the number of threads each tick is split across.
+// Besides the time per tick, reports the average time per step of every
+// phase, the time to publish a snapshot and the size of the encoded frame.
+void BM_GameUpdate(benchmark::State& state) {
+  const int players = state.range(0);
+  const int bots = state.range(1);
+  const int firing = state.range(2);
+  const int threads = state.range(3);
+
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, bots);
+  game.setTickThreads(threads);
+  game.start(false);
+  for (int i = 0; i < players; i++) {
+    PlayerInput input;
+    input.set_username("pilot" + std::to_string(i));
+    // bots already have token0 and up
+    input.set_token("pilot-token" + std::to_string(i));
+    input.set_thrust(i % 2 == 0);
+    input.set_rotate_left(i % 3 == 0);
+    input.set_fire(i * 100 < firing * players);
+    game.createNewPlayer(&input);
+  }
+  for (int i = 0; i < kWarmupTicks; i++) {
+    clock->advance(kTick);
+    game.update();
+  }
+
+  const PhaseTimes before = game.phaseTimes();
+  int64_t frame_bytes = 0;
+  int64_t bullets = 0;
+  for (auto _ : state) {
+    clock->advance(kTick);
+    game.update();
+    std::shared_ptr<const Snapshot> snapshot = game.getSnapshot();
+    frame_bytes += snapshot->frame.ByteSizeLong();
+    bullets += snapshot->world.bullets_size();
+  }
+  const PhaseTimes after = game.phaseTimes();
+  game.end();
+
+  const double steps = after.steps - before.steps;
+  const double snapshots = after.snapshots - before.snapshots;
+  state.counters["inputs_ns"] = (after.inputs - before.inputs) / steps;
+  state.counters["bullet_collisions_ns"] =
+      (after.bullet_collisions - before.bullet_collisions) / steps;
+  state.counters["ships_ns"] = (after.ships - before.ships) / steps;
+  state.counters["bullets_ns"] = (after.bullets - before.bullets) / steps;
+  state.counters["explosions_ns"] =
+      (after.explosions - before.explosions) / steps;
+  state.counters["ai_ns"] = (after.ai - before.ai) / steps;
+  state.counters["snapshot_ns"] =
+      (after.snapshot - before.snapshot) / snapshots;
+  state.counters["frame_bytes"] = benchmark::Counter(
+      frame_bytes, benchmark::Counter::kAvgIterations);
+  state.counters["bullets"] =
+      benchmark::Counter(bullets, benchmark::Counter::kAvgIterations);
+}
+
+// every combination of players, bots and percent of players firing on one
+// thread, then a crowded game on more threads
+void sweep(benchmark::internal::Benchmark* b) {
+  for (int players : {0, 16, 128, 512}) {
+    for (int bots : {4, 64}) {
+      for (int firing : {0, 50, 100}) {
+        b->Args({players, bots, firing, 1});
+      }
+    }
+  }
+  // the busiest game, split across more and more threads
+  for (int threads : {1, 2, 4, 8}) {
+    b->Args({2048, 64, 100, threads});
+  }
+}
+BENCHMARK(BM_GameUpdate)
+    ->ArgNames({"players", "bots", "firing", "threads"})
+    ->Apply(sweep)
+    ->Iterations(2048)
+    ->Unit(benchmark::kMicrosecond);
+
+// Runs the game loop while another thread logs in a burst of players.
+//
+// The argument picks how players join: 0 adds each one straight away with
+// createNewPlayer, under the game's lock, 1 queues them with join for the
+// game to admit at the start of its steps. Each iteration is a whole burst,
+// ticking until every player is in the world, and reports the mean and
+// worst time update() took during it.
+void BM_JoinBurst(benchmark::State& state) {
+  static constexpr int kBurst = 1000;
+  static constexpr int kBots = 4;
+  const bool queued = state.range(0);
+
+  Hoist::nanos_t total = 0;
+  Hoist::nanos_t worst = 0;
+  int64_t ticks = 0;
+  for (auto _ : state) {
+    std::shared_ptr<Hoist::ManualClock> clock =
+        std::make_shared<Hoist::ManualClock>();
+    Game game(clock, kBots);
+    game.start(false);
+    std::atomic<bool> joined(false);
+    std::thread logins([&game, &joined, queued]() {
+      for (int i = 0; i < kBurst; i++) {
+        PlayerInput input;
+        input.set_username("pilot" + std::to_string(i));
+        // bots already have token0 and up
+        input.set_token("pilot-token" + std::to_string(i));
+        if (queued) {
+          game.join(&input);
+        } else {
+          game.createNewPlayer(&input);
+        }
+      }
+      joined = true;
+    });
+    while (!joined ||
+           game.getSnapshot()->world.players_size() < kBots + kBurst) {
+      clock->advance(kTick);
+      auto start = std::chrono::steady_clock::now();
+      game.update();
+      Hoist::nanos_t took = std::chrono::nanoseconds(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+      total += took;
+      worst = std::max(worst, took);
+      ticks++;
+    }
+    logins.join();
+    game.end();
+  }
+
+  state.counters["ticks"] =
+      benchmark::Counter(ticks, benchmark::Counter::kAvgIterations);
+  state.counters["mean_tick_us"] = ticks == 0 ? 0 : total / ticks / 1000.0;
+  state.counters["worst_tick_us"] = worst / 1000.0;
+}
+BENCHMARK(BM_JoinBurst)
+    ->ArgName("queued")
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(8)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace spacefight
+
+BENCHMARK_MAIN();
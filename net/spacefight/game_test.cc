@@ -0,0 +1,311 @@
+#include "net/spacefight/game.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "gtest/gtest.h"
+#include "hoist/clock.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/recording.h"
+
+namespace spacefight {
+namespace {
+
+static constexpr Hoist::nanos_t kTick =
+    std::chrono::nanoseconds(settings::game_update_interval).count();
+
+// a game with enough ships and bullets that every phase is split up
+class CrowdedGame {
+ public:
+  CrowdedGame(const int threads, const bool exhaustive = false)
+      : clock_(std::make_shared<Hoist::ManualClock>()), game_(clock_, 64, 7) {
+    game_.setTickThreads(threads);
+    game_.setExhaustiveCollisions(exhaustive);
+    game_.start(false);
+    for (int i = 0; i < 1000; i++) {
+      PlayerInput input;
+      input.set_username("pilot" + std::to_string(i));
+      // bots already have token0 and up
+      input.set_token("pilot-token" + std::to_string(i));
+      input.set_thrust(i % 2 == 0);
+      input.set_rotate_left(i % 3 == 0);
+      input.set_fire(i % 4 != 0);
+      game_.createNewPlayer(&input);
+    }
+  }
+  ~CrowdedGame() { game_.end(); }
+
+  // run a tick and get the world it ended with
+  std::string tick() {
+    clock_->advance(kTick);
+    game_.update();
+    return game_.getSnapshot()->world.SerializeAsString();
+  }
+
+  std::shared_ptr<const Snapshot> snapshot() { return game_.getSnapshot(); }
+
+  // get the bullet, shooter and victim of every hit in the last tick
+  std::vector<std::tuple<int64_t, int64_t, int64_t>> hits() {
+    std::vector<std::tuple<int64_t, int64_t, int64_t>> hits;
+    for (const Game::Hit& hit : game_.lastHits()) {
+      hits.emplace_back(hit.bullet_id, hit.shooter_id, hit.victim_id);
+    }
+    return hits;
+  }
+
+ private:
+  std::shared_ptr<Hoist::ManualClock> clock_;
+  Game game_;
+};
+
+TEST(GameTest, ThreadsDoNotChangeTheGame) {
+  CrowdedGame serial(1);
+  CrowdedGame parallel(4);
+  for (int tick = 0; tick < 400; tick++) {
+    ASSERT_EQ(serial.tick(), parallel.tick()) << "tick " << tick;
+  }
+  // make sure the game got busy enough to split every phase
+  std::shared_ptr<const Snapshot> snapshot = parallel.snapshot();
+  EXPECT_GT(snapshot->world.bullets_size(), 256);
+  EXPECT_GT(snapshot->world.explosions_size(), 0);
+}
+
+TEST(GameTest, GridFindsTheSameHitsAsExhaustiveSearch) {
+  CrowdedGame grid(1);
+  CrowdedGame exhaustive(1, true);
+  size_t hits = 0;
+  for (int tick = 0; tick < 200; tick++) {
+    ASSERT_EQ(exhaustive.tick(), grid.tick()) << "tick " << tick;
+    ASSERT_EQ(exhaustive.hits(), grid.hits()) << "tick " << tick;
+    hits += grid.hits().size();
+  }
+  // make sure there were plenty of hits to compare
+  EXPECT_GT(hits, 100u);
+}
+
+// Play a seeded match with scripted pilots and fold every world it sends
+// into one FNV-1a digest. The digest is golden: it only changes when the
+// game is meant to play out differently, so an optimization that changes
+// it has changed the game.
+uint64_t playScriptedMatch(const int ticks) {
+  static constexpr int kPilots = 24;
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 8, 42);
+  game.start(false);
+  for (int i = 0; i < kPilots; i++) {
+    PlayerInput input;
+    input.set_username("pilot" + std::to_string(i));
+    input.set_token("pilot-token" + std::to_string(i));
+    game.createNewPlayer(&input);
+  }
+
+  uint64_t digest = 14695981039346656037ULL;
+  for (int tick = 0; tick < ticks; tick++) {
+    for (int i = 0; i < kPilots; i++) {
+      PlayerInput input;
+      input.set_token("pilot-token" + std::to_string(i));
+      const int phase = tick / (7 + i) + i;
+      input.set_thrust(phase % 2 == 0);
+      input.set_rotate_left(phase % 3 == 0);
+      input.set_rotate_right(phase % 5 == 0);
+      input.set_fire((tick + i) % 9 < 4);
+      game.apply(&input);
+    }
+    clock->advance(kTick);
+    game.update();
+    for (const unsigned char c :
+         game.getSnapshot()->world.SerializeAsString()) {
+      digest = (digest ^ c) * 1099511628211ULL;
+    }
+  }
+  game.end();
+  return digest;
+}
+
+TEST(GameTest, ScriptedMatchPlaysOutAsBefore) {
+  EXPECT_EQ(0x2792e7e63de6a8d7ULL, playScriptedMatch(4000));
+}
+
+TEST(GameTest, WaitForSnapshotWakesOnPublish) {
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 0);
+  game.start(false);
+  const int64_t tick = game.getSnapshot()->tick;
+
+  std::shared_ptr<const Snapshot> woken;
+  std::thread waiter([&game, &woken, tick]() {
+    // long enough that only the update can end the wait
+    woken = game.waitForSnapshot(tick, 60000000000LL);
+  });
+  clock->advance(kTick);
+  game.update();
+  waiter.join();
+
+  ASSERT_NE(nullptr, woken);
+  EXPECT_EQ(tick + 1, woken->tick);
+  game.end();
+}
+
+TEST(GameTest, WaitForSnapshotTimesOut) {
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 0);
+  game.start(false);
+  std::shared_ptr<const Snapshot> snapshot = game.getSnapshot();
+
+  EXPECT_EQ(snapshot, game.waitForSnapshot(snapshot->tick, 1000000));
+  game.end();
+}
+
+TEST(GameTest, WaitForSnapshotEndsWithTheGame) {
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 0);
+  game.start(false);
+  const int64_t tick = game.getSnapshot()->tick;
+
+  std::thread waiter([&game, tick]() {
+    EXPECT_EQ(nullptr, game.waitForSnapshot(tick, 60000000000LL));
+  });
+  game.end();
+  waiter.join();
+}
+
+PlayerInput pilot(const int i) {
+  PlayerInput input;
+  input.set_username("pilot" + std::to_string(i));
+  // bots already have token0 and up
+  input.set_token("pilot-token" + std::to_string(i));
+  return input;
+}
+
+TEST(GameTest, JoinAdmitsAtTheNextStep) {
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 2);
+  game.start(false);
+  PlayerInput input = pilot(0);
+  const int64_t player_id = game.join(&input);
+  // bots took the first ids
+  EXPECT_EQ(3, player_id);
+  EXPECT_EQ(2, game.getSnapshot()->world.players_size());
+
+  clock->advance(kTick);
+  game.update();
+  const World& world = game.getSnapshot()->world;
+  ASSERT_EQ(3, world.players_size());
+  EXPECT_EQ(player_id, world.players(2).id());
+  EXPECT_EQ("pilot0", world.players(2).username());
+  game.end();
+}
+
+TEST(GameTest, JoinsAreAdmittedInBoundedBatches) {
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 0);
+  game.start(false);
+  const int joins = 2 * settings::max_joins_per_step + 1;
+  for (int i = 0; i < joins; i++) {
+    PlayerInput input = pilot(i);
+    EXPECT_EQ(i + 1, game.join(&input));
+  }
+  for (int batch = 1; batch <= 3; batch++) {
+    clock->advance(kTick);
+    game.update();
+    EXPECT_EQ(std::min<int>(joins, batch * settings::max_joins_per_step),
+              game.getSnapshot()->world.players_size());
+  }
+  // oldest first
+  const World& world = game.getSnapshot()->world;
+  for (int i = 0; i < joins; i++) {
+    EXPECT_EQ(i + 1, world.players(i).id());
+  }
+  game.end();
+}
+
+TEST(GameTest, QuitBeforeAdmissionNeverJoins) {
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 0);
+  game.start(false);
+  // fill this step, so the last player waits for the next one
+  for (size_t i = 0; i <= settings::max_joins_per_step; i++) {
+    PlayerInput input = pilot(i);
+    game.join(&input);
+  }
+  PlayerInput input = pilot(settings::max_joins_per_step);
+  input.set_quit(true);
+  game.apply(&input);
+
+  for (int tick = 0; tick < 2; tick++) {
+    clock->advance(kTick);
+    game.update();
+  }
+  EXPECT_EQ(settings::max_joins_per_step,
+            game.getSnapshot()->world.players_size());
+  game.end();
+}
+
+TEST(GameTest, InputBeforeAdmissionIsKept) {
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 0);
+  game.start(false);
+  // fill this step, so the last player waits for the next one
+  for (size_t i = 0; i <= settings::max_joins_per_step; i++) {
+    PlayerInput input = pilot(i);
+    game.join(&input);
+  }
+  // clients only send controls when they change, so this is sent once
+  PlayerInput input = pilot(settings::max_joins_per_step);
+  input.set_thrust(true);
+  game.apply(&input);
+
+  clock->advance(kTick);
+  game.update();
+  ASSERT_EQ(settings::max_joins_per_step,
+            game.getSnapshot()->world.players_size());
+  clock->advance(kTick);
+  game.update();
+  const World& world = game.getSnapshot()->world;
+  ASSERT_EQ(settings::max_joins_per_step + 1, world.players_size());
+  EXPECT_FALSE(world.players(0).is_thrusting());
+  EXPECT_TRUE(world.players(settings::max_joins_per_step).is_thrusting());
+  game.end();
+}
+
+TEST(GameTest, QuitBetweenDrainsNeverJoins) {
+  std::shared_ptr<Hoist::ManualClock> clock =
+      std::make_shared<Hoist::ManualClock>();
+  Game game(clock, 0);
+  game.start(false);
+  // the join misses the step's drain of joins and its quit is applied in the
+  // same step, as when both are pushed between the drain of joins and the
+  // drain of inputs. replaying the quit applies it at exactly that point.
+  PlayerInput input = pilot(0);
+  game.join(&input);
+  Record quit{Record::kQuit};
+  quit.token = input.token();
+  game.replay(quit);
+
+  for (int tick = 0; tick < 2; tick++) {
+    clock->advance(kTick);
+    game.update();
+  }
+  EXPECT_EQ(0, game.getSnapshot()->world.players_size());
+  game.end();
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
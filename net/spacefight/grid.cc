@@ -0,0 +1,57 @@
+#include "net/spacefight/grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace spacefight {
+
+void SpatialGrid::clear() { entries_.clear(); }
+
+void SpatialGrid::insert(const int id, const phys::AABB& box) {
+  int32_t cx1 = cell(box.x1);
+  int32_t cy1 = cell(box.y1);
+  int32_t cx2 = cell(box.x2);
+  int32_t cy2 = cell(box.y2);
+  for (int32_t cx = cx1; cx <= cx2; cx++) {
+    for (int32_t cy = cy1; cy <= cy2; cy++) {
+      entries_.emplace_back(key(cx, cy), id);
+    }
+  }
+}
+
+void SpatialGrid::build() { std::sort(entries_.begin(), entries_.end()); }
+
+void SpatialGrid::query(const phys::AABB& box, std::vector<int>* out) const {
+  size_t first = out->size();
+  int32_t cx1 = cell(box.x1);
+  int32_t cy1 = cell(box.y1);
+  int32_t cx2 = cell(box.x2);
+  int32_t cy2 = cell(box.y2);
+  for (int32_t cx = cx1; cx <= cx2; cx++) {
+    for (int32_t cy = cy1; cy <= cy2; cy++) {
+      CellKey k = key(cx, cy);
+      auto it = std::lower_bound(entries_.begin(), entries_.end(),
+                                 Entry(k, INT32_MIN));
+      for (; it != entries_.end() && it->first == k; ++it) {
+        out->push_back(it->second);
+      }
+    }
+  }
+  // each cell is already sorted by id, only spanning cells needs a merge
+  if (cx1 != cx2 || cy1 != cy2) {
+    std::sort(out->begin() + first, out->end());
+    out->erase(std::unique(out->begin() + first, out->end()), out->end());
+  }
+}
+
+int32_t SpatialGrid::cell(const float f) const {
+  // floor is monotonic, so touching edges always land in a shared cell
+  return static_cast<int32_t>(std::floor(f * inv_cell_size_));
+}
+
+SpatialGrid::CellKey SpatialGrid::key(const int32_t cx, const int32_t cy) {
+  return (static_cast<CellKey>(static_cast<uint32_t>(cx)) << 32) |
+         static_cast<uint32_t>(cy);
+}
+
+}  // namespace spacefight
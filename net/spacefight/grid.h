@@ -0,0 +1,52 @@
+#ifndef NET_SPACEFIGHT_GRID_H
+#define NET_SPACEFIGHT_GRID_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "net/spacefight/physics.h"
+
+namespace spacefight {
+
+// SpatialGrid is a uniform-grid broad phase.
+//
+// Boxes are bucketed into every cell they overlap. A query returns every box
+// that shares at least one cell with the query box, which is a superset of the
+// boxes that actually intersect it. The grid is meant to be rebuilt each tick:
+// clear(), insert() everything, build(), then query().
+class SpatialGrid final {
+ public:
+  explicit SpatialGrid(const float cell_size)
+      : inv_cell_size_(1.0f / cell_size) {}
+
+  SpatialGrid(const SpatialGrid&) = delete;
+  SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+  // remove all boxes, keeping allocated storage for reuse
+  void clear();
+
+  // add a box under an id
+  void insert(const int id, const phys::AABB& box);
+
+  // prepare the inserted boxes for querying
+  void build();
+
+  // collect the ids of boxes that may intersect a box.
+  // ids are appended to out in ascending order, without duplicates.
+  void query(const phys::AABB& box, std::vector<int>* out) const;
+
+ private:
+  typedef uint64_t CellKey;
+  typedef std::pair<CellKey, int> Entry;
+
+  float inv_cell_size_;
+  // (cell, id) pairs sorted by cell after build()
+  std::vector<Entry> entries_;
+
+  int32_t cell(const float f) const;
+  static CellKey key(const int32_t cx, const int32_t cy);
+};
+
+}  // namespace spacefight
+
+#endif
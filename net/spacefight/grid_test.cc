@@ -0,0 +1,191 @@
+#include "net/spacefight/grid.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/physics.h"
+
+namespace spacefight {
+namespace {
+
+static constexpr float kDt = 0.026f;
+
+game::Body makeBody(float x, float y, float dx, float dy, float size) {
+  game::Body body;
+  phys::set(body.mutable_phys(), x, y, dx, dy);
+  phys::set(body.mutable_size(), size, size);
+  return body;
+}
+
+// the first ship hit by a bullet, testing every ship
+int firstHitExhaustive(const std::vector<game::Body>& ships,
+                       const game::Body& bullet) {
+  for (int pi = 0; pi < static_cast<int>(ships.size()); pi++) {
+    if (phys::willCollide(ships[pi], bullet, kDt)) {
+      return pi;
+    }
+  }
+  return -1;
+}
+
+// the first ship hit by a bullet, testing only broad phase candidates
+int firstHitGrid(const SpatialGrid& ship_grid,
+                 const std::vector<game::Body>& ships,
+                 const game::Body& bullet) {
+  std::vector<int> candidates;
+  ship_grid.query(phys::futureBounds(bullet, kDt), &candidates);
+  for (int pi : candidates) {
+    if (phys::willCollide(ships[pi], bullet, kDt)) {
+      return pi;
+    }
+  }
+  return -1;
+}
+
+void buildGrid(SpatialGrid* ship_grid, const std::vector<game::Body>& ships) {
+  ship_grid->clear();
+  for (int pi = 0; pi < static_cast<int>(ships.size()); pi++) {
+    ship_grid->insert(pi, phys::futureBounds(ships[pi], kDt));
+  }
+  ship_grid->build();
+}
+
+TEST(SpatialGridTest, Empty) {
+  SpatialGrid ship_grid(grid::cell_size);
+  ship_grid.build();
+
+  std::vector<int> candidates;
+  ship_grid.query(phys::futureBounds(makeBody(0, 0, 0, 0, 10), kDt),
+                  &candidates);
+
+  EXPECT_TRUE(candidates.empty());
+}
+
+TEST(SpatialGridTest, CandidatesAreSortedAndUnique) {
+  SpatialGrid ship_grid(grid::cell_size);
+  std::vector<game::Body> ships;
+  // ships straddling the same four cells
+  for (int i = 0; i < 5; i++) {
+    ships.push_back(makeBody(-25, -25, 0, 0, ships::size));
+  }
+  buildGrid(&ship_grid, ships);
+
+  std::vector<int> candidates;
+  ship_grid.query(
+      phys::futureBounds(makeBody(-1000, -1000, 0, 0, 2000), kDt),
+      &candidates);
+
+  EXPECT_EQ(candidates, std::vector<int>({0, 1, 2, 3, 4}));
+}
+
+TEST(SpatialGridTest, TouchingEdgesOnCellBoundary) {
+  SpatialGrid ship_grid(grid::cell_size);
+  // a ship ending exactly where a cell and the bullet begin
+  std::vector<game::Body> ships = {
+      makeBody(grid::cell_size - ships::size, 0, 0, 0, ships::size)};
+  buildGrid(&ship_grid, ships);
+
+  game::Body bullet = makeBody(grid::cell_size, 10, 0, 0, bullets::size);
+
+  ASSERT_EQ(0, firstHitExhaustive(ships, bullet));
+  EXPECT_EQ(0, firstHitGrid(ship_grid, ships, bullet));
+}
+
+TEST(SpatialGridTest, MatchesExhaustiveSearch) {
+  std::mt19937 rng(1234);
+  // a crowded area so that many bullets hit one or more ships
+  std::uniform_real_distribution<float> pos(-600, 600);
+  std::uniform_real_distribution<float> ship_vel(-ships::max_vel,
+                                                 ships::max_vel);
+  std::uniform_real_distribution<float> bullet_vel(
+      -bullets::vel - ships::max_vel, bullets::vel + ships::max_vel);
+
+  SpatialGrid ship_grid(grid::cell_size);
+  int hits = 0;
+  for (int round = 0; round < 20; round++) {
+    std::vector<game::Body> ships;
+    for (int pi = 0; pi < 300; pi++) {
+      ships.push_back(makeBody(pos(rng), pos(rng), ship_vel(rng),
+                               ship_vel(rng), ships::size));
+    }
+    buildGrid(&ship_grid, ships);
+
+    for (int bi = 0; bi < 2000; bi++) {
+      game::Body bullet = makeBody(pos(rng), pos(rng), bullet_vel(rng),
+                                   bullet_vel(rng), bullets::size);
+      int expected = firstHitExhaustive(ships, bullet);
+      ASSERT_EQ(expected, firstHitGrid(ship_grid, ships, bullet))
+          << "round " << round << " bullet " << bi;
+      if (expected >= 0) {
+        hits++;
+      }
+    }
+  }
+  // make sure the scenario actually exercised collisions
+  EXPECT_GT(hits, 1000);
+}
+
+// the box a body passes through over dt
+phys::AABB sweptBox(const game::Body& body, const float dt) {
+  return phys::sweptBounds(phys::futureBounds(body, 0),
+                           body.phys().vel().x() * dt,
+                           body.phys().vel().y() * dt);
+}
+
+TEST(SpatialGridTest, SweptMatchesExhaustiveSearch) {
+  // steps long enough for bullets to pass through ships
+  static constexpr float kLongDt = 8 * kDt;
+  std::mt19937 rng(4321);
+  std::uniform_real_distribution<float> pos(-600, 600);
+  std::uniform_real_distribution<float> ship_vel(-ships::max_vel,
+                                                 ships::max_vel);
+  std::uniform_real_distribution<float> bullet_vel(
+      -bullets::vel - ships::max_vel, bullets::vel + ships::max_vel);
+
+  SpatialGrid ship_grid(grid::cell_size);
+  int hits = 0;
+  int tunnels = 0;
+  for (int round = 0; round < 10; round++) {
+    std::vector<game::Body> ships;
+    ship_grid.clear();
+    for (int pi = 0; pi < 300; pi++) {
+      ships.push_back(makeBody(pos(rng), pos(rng), ship_vel(rng),
+                               ship_vel(rng), ships::size));
+      ship_grid.insert(pi, sweptBox(ships.back(), kLongDt));
+    }
+    ship_grid.build();
+
+    for (int bi = 0; bi < 1000; bi++) {
+      game::Body bullet = makeBody(pos(rng), pos(rng), bullet_vel(rng),
+                                   bullet_vel(rng), bullets::size);
+      std::vector<int> candidates;
+      ship_grid.query(sweptBox(bullet, kLongDt), &candidates);
+      float toi;
+      for (int pi = 0; pi < static_cast<int>(ships.size()); pi++) {
+        if (!phys::sweptCollide(ships[pi], bullet, kLongDt, &toi)) {
+          continue;
+        }
+        hits++;
+        ASSERT_TRUE(std::binary_search(candidates.begin(), candidates.end(),
+                                       pi))
+            << "round " << round << " bullet " << bi << " ship " << pi;
+        if (!phys::willCollide(ships[pi], bullet, kLongDt)) {
+          tunnels++;
+        }
+      }
+    }
+  }
+  // make sure the scenario hit ships, including ones the end positions miss
+  EXPECT_GT(hits, 1000);
+  EXPECT_GT(tunnels, 100);
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
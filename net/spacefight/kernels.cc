@@ -0,0 +1,194 @@
+#include "net/spacefight/kernels.h"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace spacefight {
+namespace phys {
+
+namespace {
+
+// Floats is a vector register of kLanes floats, with the handful of
+// operations the kernels need, so each kernel is written once.
+#if defined(__AVX2__)
+
+static constexpr size_t kLanes = 8;
+typedef __m256 Floats;
+inline Floats load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, const Floats v) { _mm256_storeu_ps(p, v); }
+inline Floats splat(const float f) { return _mm256_set1_ps(f); }
+inline Floats add(const Floats a, const Floats b) {
+  return _mm256_add_ps(a, b);
+}
+inline Floats sub(const Floats a, const Floats b) {
+  return _mm256_sub_ps(a, b);
+}
+inline Floats mul(const Floats a, const Floats b) {
+  return _mm256_mul_ps(a, b);
+}
+inline Floats div(const Floats a, const Floats b) {
+  return _mm256_div_ps(a, b);
+}
+inline Floats sqrt(const Floats a) { return _mm256_sqrt_ps(a); }
+inline Floats greater(const Floats a, const Floats b) {
+  return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+}
+inline Floats lessEqual(const Floats a, const Floats b) {
+  return _mm256_cmp_ps(a, b, _CMP_LE_OQ);
+}
+inline Floats both(const Floats a, const Floats b) {
+  return _mm256_and_ps(a, b);
+}
+// lanes of b where mask is set, otherwise lanes of a
+inline Floats select(const Floats mask, const Floats a, const Floats b) {
+  return _mm256_blendv_ps(a, b, mask);
+}
+inline uint32_t bits(const Floats mask) { return _mm256_movemask_ps(mask); }
+
+#elif defined(__SSE2__)
+
+static constexpr size_t kLanes = 4;
+typedef __m128 Floats;
+inline Floats load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, const Floats v) { _mm_storeu_ps(p, v); }
+inline Floats splat(const float f) { return _mm_set1_ps(f); }
+inline Floats add(const Floats a, const Floats b) { return _mm_add_ps(a, b); }
+inline Floats sub(const Floats a, const Floats b) { return _mm_sub_ps(a, b); }
+inline Floats mul(const Floats a, const Floats b) { return _mm_mul_ps(a, b); }
+inline Floats div(const Floats a, const Floats b) { return _mm_div_ps(a, b); }
+inline Floats sqrt(const Floats a) { return _mm_sqrt_ps(a); }
+inline Floats greater(const Floats a, const Floats b) {
+  return _mm_cmpgt_ps(a, b);
+}
+inline Floats lessEqual(const Floats a, const Floats b) {
+  return _mm_cmple_ps(a, b);
+}
+inline Floats both(const Floats a, const Floats b) { return _mm_and_ps(a, b); }
+// lanes of b where mask is set, otherwise lanes of a
+inline Floats select(const Floats mask, const Floats a, const Floats b) {
+  return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+inline uint32_t bits(const Floats mask) { return _mm_movemask_ps(mask); }
+
+#else
+
+// no vector registers, every element is handled by the scalar tail
+static constexpr size_t kLanes = 1;
+
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#define SPACEFIGHT_VECTOR_KERNELS 1
+#endif
+
+// get the end of the elements that fill whole vector registers
+inline size_t vectorEnd(const size_t n) { return n - n % kLanes; }
+
+}  // namespace
+
+size_t kernelLanes() { return kLanes; }
+
+void integrate(float* x, float* y, const float* dx, const float* dy,
+               const size_t n, const float dt) {
+  size_t i = 0;
+#ifdef SPACEFIGHT_VECTOR_KERNELS
+  const Floats t = splat(dt);
+  for (; i < vectorEnd(n); i += kLanes) {
+    store(x + i, add(load(x + i), mul(load(dx + i), t)));
+    store(y + i, add(load(y + i), mul(load(dy + i), t)));
+  }
+#endif
+  for (; i < n; i++) {
+    x[i] += dx[i] * dt;
+    y[i] += dy[i] * dt;
+  }
+}
+
+void rotate(float* x, float* y, const size_t n, const float radians) {
+  const float s = std::sin(radians);
+  const float c = std::cos(radians);
+  size_t i = 0;
+#ifdef SPACEFIGHT_VECTOR_KERNELS
+  const Floats vs = splat(s);
+  const Floats vc = splat(c);
+  for (; i < vectorEnd(n); i += kLanes) {
+    Floats x0 = load(x + i);
+    Floats y0 = load(y + i);
+    store(x + i, sub(mul(x0, vc), mul(y0, vs)));
+    store(y + i, add(mul(x0, vs), mul(y0, vc)));
+  }
+#endif
+  for (; i < n; i++) {
+    float x0 = x[i];
+    float y0 = y[i];
+    x[i] = x0 * c - y0 * s;
+    y[i] = x0 * s + y0 * c;
+  }
+}
+
+void clampMagnitude(float* x, float* y, const size_t n, const float max) {
+  // compare squared magnitudes, so vectors that fit need no square root
+  const float max2 = max * max;
+  size_t i = 0;
+#ifdef SPACEFIGHT_VECTOR_KERNELS
+  const Floats vmax = splat(max);
+  const Floats vmax2 = splat(max2);
+  for (; i < vectorEnd(n); i += kLanes) {
+    Floats x0 = load(x + i);
+    Floats y0 = load(y + i);
+    Floats length2 = add(mul(x0, x0), mul(y0, y0));
+    Floats over = greater(length2, vmax2);
+    if (bits(over) == 0) {
+      continue;
+    }
+    Floats p = div(vmax, sqrt(length2));
+    store(x + i, select(over, x0, mul(x0, p)));
+    store(y + i, select(over, y0, mul(y0, p)));
+  }
+#endif
+  for (; i < n; i++) {
+    float length2 = x[i] * x[i] + y[i] * y[i];
+    if (length2 > max2) {
+      float p = max / std::sqrt(length2);
+      x[i] *= p;
+      y[i] *= p;
+    }
+  }
+}
+
+size_t intersecting(const AABB& box, const float* x1, const float* y1,
+                    const float* x2, const float* y2, const size_t n,
+                    uint32_t* hits) {
+  size_t count = 0;
+  size_t i = 0;
+#ifdef SPACEFIGHT_VECTOR_KERNELS
+  const Floats bx1 = splat(box.x1);
+  const Floats by1 = splat(box.y1);
+  const Floats bx2 = splat(box.x2);
+  const Floats by2 = splat(box.y2);
+  for (; i < vectorEnd(n); i += kLanes) {
+    Floats overlap = both(both(lessEqual(bx1, load(x2 + i)),
+                               lessEqual(load(x1 + i), bx2)),
+                          both(lessEqual(by1, load(y2 + i)),
+                               lessEqual(load(y1 + i), by2)));
+    for (uint32_t mask = bits(overlap); mask != 0; mask &= mask - 1) {
+      hits[count++] = i + __builtin_ctz(mask);
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    if (box.x1 <= x2[i] && x1[i] <= box.x2 && box.y1 <= y2[i] &&
+        y1[i] <= box.y2) {
+      hits[count++] = i;
+    }
+  }
+  return count;
+}
+
+}  // namespace phys
+}  // namespace spacefight
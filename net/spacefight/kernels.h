@@ -0,0 +1,40 @@
+#ifndef NET_SPACEFIGHT_KERNELS_H
+#define NET_SPACEFIGHT_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "net/spacefight/physics.h"
+
+namespace spacefight {
+namespace phys {
+
+// Batch kernels, the physics functions over packed arrays of n floats.
+//
+// Each kernel works through its arrays with AVX2 when built with -mavx2
+// (--config=avx2), with SSE2 on any other x86-64 build, and one element at
+// a time elsewhere. Arrays need no particular alignment.
+
+// get the number of floats each kernel works on at once
+size_t kernelLanes();
+
+// move n positions along their velocities for a given time interval
+void integrate(float* x, float* y, const float* dx, const float* dy,
+               const size_t n, const float dt);
+
+// rotate n vectors by the same angle
+void rotate(float* x, float* y, const size_t n, const float radians);
+
+// clamp the magnitude of n vectors, preserving their angles
+void clampMagnitude(float* x, float* y, const size_t n, const float max);
+
+// Find which of n boxes, each spanning [x1, x2] and [y1, y2], intersect a
+// box, edges included. Writes the indices of the boxes that do into hits in
+// ascending order and returns how many there are. hits must have room for n.
+size_t intersecting(const AABB& box, const float* x1, const float* y1,
+                    const float* x2, const float* y2, const size_t n,
+                    uint32_t* hits);
+
+}  // namespace phys
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,156 @@
+#include "net/spacefight/kernels.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "net/spacefight/physics.h"
+#include "proto/spacefight/spacefight.pb.h"
+
+namespace spacefight {
+namespace phys {
+namespace {
+
+static constexpr float kDt = 0.016f;
+
+// n bodies scattered around the origin, stored both as protos and as packed
+// arrays
+struct Scene {
+  std::vector<game::Body> bodies;
+  std::vector<float> x, y, dx, dy, x1, y1, x2, y2;
+
+  explicit Scene(const size_t n) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(-2000, 2000);
+    std::uniform_real_distribution<float> vel(-300, 300);
+    for (size_t i = 0; i < n; i++) {
+      game::Body body;
+      set(body.mutable_phys(), pos(rng), pos(rng), vel(rng), vel(rng));
+      set(body.mutable_size(), 20, 20);
+      bodies.push_back(body);
+      x.push_back(body.phys().pos().x());
+      y.push_back(body.phys().pos().y());
+      dx.push_back(body.phys().vel().x());
+      dy.push_back(body.phys().vel().y());
+      x1.push_back(x.back() + dx.back() * kDt);
+      y1.push_back(y.back() + dy.back() * kDt);
+      x2.push_back(x1.back() + 20);
+      y2.push_back(y1.back() + 20);
+    }
+  }
+};
+
+void BM_UpdateBodies(benchmark::State& state) {
+  Scene scene(state.range(0));
+  for (auto _ : state) {
+    for (game::Body& body : scene.bodies) {
+      update(&body, kDt);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UpdateBodies)->Range(64, 16384);
+
+void BM_Integrate(benchmark::State& state) {
+  Scene scene(state.range(0));
+  for (auto _ : state) {
+    integrate(scene.x.data(), scene.y.data(), scene.dx.data(),
+              scene.dy.data(), scene.x.size(), kDt);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Integrate)->Range(64, 16384);
+
+void BM_RotateVectors(benchmark::State& state) {
+  Scene scene(state.range(0));
+  for (auto _ : state) {
+    for (game::Body& body : scene.bodies) {
+      rotate(body.mutable_phys()->mutable_vel(), 0.01f);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RotateVectors)->Range(64, 16384);
+
+void BM_Rotate(benchmark::State& state) {
+  Scene scene(state.range(0));
+  for (auto _ : state) {
+    rotate(scene.dx.data(), scene.dy.data(), scene.dx.size(), 0.01f);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Rotate)->Range(64, 16384);
+
+// about half of the vectors are over the limit, so each iteration clamps a
+// fresh copy
+void BM_ClampVectors(benchmark::State& state) {
+  Scene scene(state.range(0));
+  std::vector<game::Body> bodies;
+  for (auto _ : state) {
+    state.PauseTiming();
+    bodies = scene.bodies;
+    state.ResumeTiming();
+    for (game::Body& body : bodies) {
+      clampMagnitude(body.mutable_phys()->mutable_vel(), 300);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ClampVectors)->Range(64, 16384);
+
+void BM_ClampMagnitude(benchmark::State& state) {
+  Scene scene(state.range(0));
+  std::vector<float> dx;
+  std::vector<float> dy;
+  for (auto _ : state) {
+    state.PauseTiming();
+    dx = scene.dx;
+    dy = scene.dy;
+    state.ResumeTiming();
+    clampMagnitude(dx.data(), dy.data(), dx.size(), 300);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ClampMagnitude)->Range(64, 16384);
+
+// one body against every other, as a ship checks the bullets near it
+void BM_WillCollide(benchmark::State& state) {
+  Scene scene(state.range(0));
+  const game::Body& probe = scene.bodies[0];
+  for (auto _ : state) {
+    int64_t hits = 0;
+    for (const game::Body& body : scene.bodies) {
+      hits += willCollide(probe, body, kDt);
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WillCollide)->Range(64, 16384);
+
+void BM_Intersecting(benchmark::State& state) {
+  Scene scene(state.range(0));
+  const AABB probe = futureBounds(scene.bodies[0], kDt);
+  std::vector<uint32_t> hits(scene.x.size());
+  for (auto _ : state) {
+    size_t count =
+        intersecting(probe, scene.x1.data(), scene.y1.data(), scene.x2.data(),
+                     scene.y2.data(), scene.x1.size(), hits.data());
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["lanes"] = kernelLanes();
+}
+BENCHMARK(BM_Intersecting)->Range(64, 16384);
+
+}  // namespace
+}  // namespace phys
+}  // namespace spacefight
+
+BENCHMARK_MAIN();
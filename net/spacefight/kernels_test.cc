@@ -0,0 +1,139 @@
+#include "net/spacefight/kernels.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "net/spacefight/physics.h"
+
+namespace spacefight {
+namespace phys {
+namespace {
+
+// sizes that leave every possible tail after the full vector registers
+static constexpr size_t kSizes[] = {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 100};
+
+std::vector<float> randoms(const size_t n, std::mt19937* rng, const float lo,
+                           const float hi) {
+  std::uniform_real_distribution<float> dist(lo, hi);
+  std::vector<float> v(n);
+  for (float& f : v) {
+    f = dist(*rng);
+  }
+  return v;
+}
+
+TEST(KernelsTest, IntegrateMatchesUpdate) {
+  std::mt19937 rng(1);
+  for (size_t n : kSizes) {
+    std::vector<float> x = randoms(n, &rng, -1000, 1000);
+    std::vector<float> y = randoms(n, &rng, -1000, 1000);
+    std::vector<float> dx = randoms(n, &rng, -300, 300);
+    std::vector<float> dy = randoms(n, &rng, -300, 300);
+    std::vector<float> ex = x;
+    std::vector<float> ey = y;
+
+    integrate(x.data(), y.data(), dx.data(), dy.data(), n, 0.016f);
+    for (size_t i = 0; i < n; i++) {
+      game::Body body;
+      set(body.mutable_phys(), ex[i], ey[i], dx[i], dy[i]);
+      update(&body, 0.016f);
+      EXPECT_FLOAT_EQ(x[i], body.phys().pos().x()) << "n=" << n << " i=" << i;
+      EXPECT_FLOAT_EQ(y[i], body.phys().pos().y()) << "n=" << n << " i=" << i;
+    }
+  }
+}
+
+TEST(KernelsTest, RotateMatchesRotate) {
+  std::mt19937 rng(2);
+  for (size_t n : kSizes) {
+    std::vector<float> x = randoms(n, &rng, -10, 10);
+    std::vector<float> y = randoms(n, &rng, -10, 10);
+    std::vector<float> ex = x;
+    std::vector<float> ey = y;
+
+    rotate(x.data(), y.data(), n, 0.7f);
+    for (size_t i = 0; i < n; i++) {
+      rotate(&ex[i], &ey[i], 0.7f);
+      EXPECT_FLOAT_EQ(x[i], ex[i]) << "n=" << n << " i=" << i;
+      EXPECT_FLOAT_EQ(y[i], ey[i]) << "n=" << n << " i=" << i;
+    }
+  }
+}
+
+TEST(KernelsTest, ClampMagnitudeMatchesClampMagnitude) {
+  std::mt19937 rng(3);
+  for (size_t n : kSizes) {
+    std::vector<float> x = randoms(n, &rng, -400, 400);
+    std::vector<float> y = randoms(n, &rng, -400, 400);
+    std::vector<float> ex = x;
+    std::vector<float> ey = y;
+
+    clampMagnitude(x.data(), y.data(), n, 250);
+    for (size_t i = 0; i < n; i++) {
+      clampMagnitude(&ex[i], &ey[i], 250);
+      EXPECT_NEAR(x[i], ex[i], 1e-3) << "n=" << n << " i=" << i;
+      EXPECT_NEAR(y[i], ey[i], 1e-3) << "n=" << n << " i=" << i;
+    }
+  }
+}
+
+TEST(KernelsTest, ClampMagnitudeLeavesShortAndZeroVectors) {
+  std::vector<float> x = {0, 3, 0, 1, -2, 0, 0, 0, 6};
+  std::vector<float> y = {0, 4, -5, 1, 0, 0, 0, 0, 8};
+  clampMagnitude(x.data(), y.data(), x.size(), 5);
+  EXPECT_EQ(x, std::vector<float>({0, 3, 0, 1, -2, 0, 0, 0, 3}));
+  EXPECT_EQ(y, std::vector<float>({0, 4, -5, 1, 0, 0, 0, 0, 4}));
+}
+
+TEST(KernelsTest, IntersectingMatchesIntersects) {
+  std::mt19937 rng(4);
+  const AABB box{-50, -50, 50, 50};
+  for (size_t n : kSizes) {
+    std::vector<float> x1 = randoms(n, &rng, -200, 200);
+    std::vector<float> y1 = randoms(n, &rng, -200, 200);
+    std::vector<float> x2(n);
+    std::vector<float> y2(n);
+    for (size_t i = 0; i < n; i++) {
+      x2[i] = x1[i] + 40;
+      y2[i] = y1[i] + 40;
+    }
+
+    std::vector<uint32_t> hits(n);
+    size_t count = intersecting(box, x1.data(), y1.data(), x2.data(),
+                                y2.data(), n, hits.data());
+    hits.resize(count);
+
+    std::vector<uint32_t> expected;
+    for (size_t i = 0; i < n; i++) {
+      if (intersects(box, AABB{x1[i], y1[i], x2[i], y2[i]})) {
+        expected.push_back(i);
+      }
+    }
+    EXPECT_EQ(hits, expected) << "n=" << n;
+  }
+}
+
+TEST(KernelsTest, IntersectingIncludesEdges) {
+  const AABB box{0, 0, 10, 10};
+  // touching each edge, then just past each edge
+  std::vector<float> x1 = {10, -5, 0, 0, 10.5f, -5, 0, 0, 5};
+  std::vector<float> y1 = {0, 0, 10, -5, 0, 0, 10.5f, -5, 5};
+  std::vector<float> x2 = {15, 0, 5, 5, 15, -0.5f, 5, 5, 6};
+  std::vector<float> y2 = {5, 5, 15, 0, 5, 5, 15, -0.5f, 6};
+  std::vector<uint32_t> hits(x1.size());
+  size_t count = intersecting(box, x1.data(), y1.data(), x2.data(), y2.data(),
+                              x1.size(), hits.data());
+  hits.resize(count);
+  EXPECT_EQ(hits, std::vector<uint32_t>({0, 1, 2, 3, 8}));
+}
+
+}  // namespace
+}  // namespace phys
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,11 +1,13 @@
 #include "net/spacefight/physics.h"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 namespace spacefight {
 namespace phys {
 
-float angle(const game::Vector& v) { return atan2(v.y(), v.x()); }
+float angle(const game::Vector& v) { return angle(v.x(), v.y()); }
 
 float magnitude(const game::Vector* const v) { return hypot(v->x(), v->y()); }
 
@@ -37,23 +39,72 @@ void scale(game::Vector* v, const float p) {
 }
 
 void rotate(game::Vector* v, const float radians) {
-  float s = sin(radians);
-  float c = cos(radians);
   float x = v->x();
   float y = v->y();
-  v->set_x(x * c - y * s);
-  v->set_y(x * s + y * c);
+  rotate(&x, &y, radians);
+  set(v, x, y);
 }
 
 void clampMagnitude(game::Vector* v, const float max) {
-  float length = magnitude(v);
+  float x = v->x();
+  float y = v->y();
+  clampMagnitude(&x, &y, max);
+  set(v, x, y);
+}
+
+// Component functions
+
+float angle(const float x, const float y) { return atan2(y, x); }
+
+void rotate(float* x, float* y, const float radians) {
+  rotate(x, y, rotation(radians));
+}
+
+void clampMagnitude(float* x, float* y, const float max) {
+  float length = hypot(*x, *y);
   if (length == 0) {
     return;
   } else if (length > max) {
-    scale(v, max / length);
+    float p = max / length;
+    *x *= p;
+    *y *= p;
   }
 }
 
+void direction(const float x, const float y, float* ux, float* uy) {
+  float length = sqrt(x * x + y * y);
+  if (length == 0) {
+    *ux = 1;
+    *uy = 0;
+  } else {
+    *ux = x / length;
+    *uy = y / length;
+  }
+}
+
+// Rotation functions
+
+Rotation rotation(const float radians) {
+  float c = cos(radians);
+  float s = sin(radians);
+  return Rotation{c, s};
+}
+
+Rotation rotation(const float x, const float y) {
+  Rotation r;
+  direction(x, y, &r.c, &r.s);
+  return r;
+}
+
+Rotation inverse(const Rotation& r) { return Rotation{r.c, -r.s}; }
+
+void rotate(float* x, float* y, const Rotation& r) {
+  float x0 = *x;
+  float y0 = *y;
+  *x = x0 * r.c - y0 * r.s;
+  *y = x0 * r.s + y0 * r.c;
+}
+
 // Physics functions
 
 void reset(game::Physics* p) { set(p, 0, 0, 0, 0, 0, 0); }
@@ -79,51 +130,84 @@ void update(game::Physics* p, const float dt) {
   add(p->mutable_vel(), p->acc().x() * dt, p->acc().y() * dt);
 }
 
-// Body functions
-
-void update(game::Body* b, const float dt) { update(b->mutable_phys(), dt); }
+// Bounding box functions
 
-bool willCollide(const game::Body& a, const game::Body& b, const float dt) {
-  // future a-rectangle
-  float ax1 = a.phys().pos().x() + a.phys().vel().x() * dt;
-  float ay1 = a.phys().pos().y() + a.phys().vel().y() * dt;
-  float ax2 = ax1 + a.size().x();
-  float ay2 = ay1 + a.size().y();
-
-  // future b-rectangle
-  float bx1 = b.phys().pos().x() + b.phys().vel().x() * dt;
-  float by1 = b.phys().pos().y() + b.phys().vel().y() * dt;
-  float bx2 = bx1 + b.size().x();
-  float by2 = by1 + b.size().y();
-
-  // collision detection
-  if (ax1 > bx2 || bx1 > ax2) {
+bool intersects(const AABB& a, const AABB& b) {
+  if (a.x1 > b.x2 || b.x1 > a.x2) {
     return false;
   }
-  if (ay1 > by2 || by1 > ay2) {
+  if (a.y1 > b.y2 || b.y1 > a.y2) {
     return false;
   }
   return true;
 }
 
-bool doesCollide(const game::Body& a, const game::Body& b) {
-  float ax1 = a.phys().pos().x() + a.phys().vel().x();
-  float ay1 = a.phys().pos().y() + a.phys().vel().y();
-  float ax2 = ax1 + a.size().x();
-  float ay2 = ay1 + a.size().y();
+AABB sweptBounds(const AABB& box, const float dx, const float dy) {
+  AABB swept = box;
+  (dx < 0 ? swept.x1 : swept.x2) += dx;
+  (dy < 0 ? swept.y1 : swept.y2) += dy;
+  return swept;
+}
+
+namespace {
+
+// Narrow the interval [enter, exit] to when two spans overlap along one axis,
+// while a moves by d relative to b. Returns false if they never overlap.
+bool sweepAxis(const float a1, const float a2, const float b1, const float b2,
+               const float d, float* enter, float* exit) {
+  if (d == 0) {
+    return a1 <= b2 && b1 <= a2;
+  }
+  float t1 = (b1 - a2) / d;
+  float t2 = (b2 - a1) / d;
+  if (t1 > t2) {
+    std::swap(t1, t2);
+  }
+  *enter = std::max(*enter, t1);
+  *exit = std::min(*exit, t2);
+  return *enter <= *exit;
+}
 
-  float bx1 = b.phys().pos().x() + b.phys().vel().x();
-  float by1 = b.phys().pos().y() + b.phys().vel().y();
-  float bx2 = bx1 + b.size().x();
-  float by2 = by1 + b.size().y();
+}  // namespace
 
-  // collision detection
-  if (ax1 > bx2 || bx1 > ax2) {
+bool sweep(const AABB& a, const float adx, const float ady, const AABB& b,
+           const float bdx, const float bdy, float* toi) {
+  // move a relative to b, which then stands still
+  float enter = 0;
+  float exit = 1;
+  if (!sweepAxis(a.x1, a.x2, b.x1, b.x2, adx - bdx, &enter, &exit) ||
+      !sweepAxis(a.y1, a.y2, b.y1, b.y2, ady - bdy, &enter, &exit)) {
     return false;
   }
-  if (ay1 > by2 || by1 > ay2) {
+  *toi = enter;
+  return true;
+}
+
+// Body functions
+
+void update(game::Body* b, const float dt) { update(b->mutable_phys(), dt); }
+
+AABB futureBounds(const game::Body& b, const float dt) {
+  AABB box;
+  box.x1 = b.phys().pos().x() + b.phys().vel().x() * dt;
+  box.y1 = b.phys().pos().y() + b.phys().vel().y() * dt;
+  box.x2 = box.x1 + b.size().x();
+  box.y2 = box.y1 + b.size().y();
+  return box;
+}
+
+bool willCollide(const game::Body& a, const game::Body& b, const float dt) {
+  return intersects(futureBounds(a, dt), futureBounds(b, dt));
+}
+
+bool sweptCollide(const game::Body& a, const game::Body& b, const float dt,
+                  float* toi) {
+  if (!sweep(futureBounds(a, 0), a.phys().vel().x() * dt,
+             a.phys().vel().y() * dt, futureBounds(b, 0),
+             b.phys().vel().x() * dt, b.phys().vel().y() * dt, toi)) {
     return false;
   }
+  *toi *= dt;
   return true;
 }
 
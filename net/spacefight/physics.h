@@ -38,6 +38,42 @@ void rotate(game::Vector* v, const float radians);
 // clamps the magnitude of a vector, preserving the original angle
 void clampMagnitude(game::Vector* v, const float max);
 
+// Component functions, for vectors stored as separate x and y values
+
+// get the angle of a vector
+float angle(const float x, const float y);
+
+// rotate a vector
+void rotate(float* x, float* y, const float radians);
+
+// clamps the magnitude of a vector, preserving the original angle
+void clampMagnitude(float* x, float* y, const float max);
+
+// get the unit vector facing the same way as a vector, or (1, 0), angle zero,
+// for a zero vector
+void direction(const float x, const float y, float* ux, float* uy);
+
+// Rotation functions, for turning vectors without trigonometry
+
+// a rotation by some angle, stored as the unit vector (cos, sin) of it, so
+// rotating a vector is a complex multiplication
+struct Rotation {
+  float c;
+  float s;
+};
+
+// get the rotation by an angle
+Rotation rotation(const float radians);
+
+// get the rotation facing the same way as a vector
+Rotation rotation(const float x, const float y);
+
+// get the rotation by the opposite angle
+Rotation inverse(const Rotation& r);
+
+// rotate a vector
+void rotate(float* x, float* y, const Rotation& r);
+
 // Physics functions
 
 // set all properties of a physics to zero
@@ -53,14 +89,43 @@ void set(game::Physics* p, const float x, const float y, const float dx,
 // apply velocity and acceleration for a given time interval
 void update(game::Physics* p, const float dt);
 
+// Bounding box functions
+
+// an axis-aligned bounding box spanning [x1, x2] and [y1, y2]
+struct AABB {
+  float x1;
+  float y1;
+  float x2;
+  float y2;
+};
+
+// test to see if two bounding boxes intersect, edges included
+bool intersects(const AABB& a, const AABB& b);
+
+// get the box covering every place a box passes through while it moves by
+// (dx, dy)
+AABB sweptBounds(const AABB& box, const float dx, const float dy);
+
+// Find the first time two boxes touch, edges included, while a moves by
+// (adx, ady) and b moves by (bdx, bdy), both over the same interval.
+// Returns whether they touch during the interval, and if so sets toi to when
+// they first do, as a fraction of the interval in [0, 1].
+bool sweep(const AABB& a, const float adx, const float ady, const AABB& b,
+           const float bdx, const float bdy, float* toi);
+
 // Body functions
 
 // apply velocity and acceleration for a given time interval
 void update(game::Body* b, const float dt);
+// get the bounding box of a body as it will be in dt seconds
+AABB futureBounds(const game::Body& b, const float dt);
 // test to see if two bodies will intersect in dt seconds
 bool willCollide(const game::Body& a, const game::Body& b, const float dt);
-// test to see if two bodies intersect
-bool doesCollide(const game::Body& a, const game::Body& b);
+// Test to see if two bodies touch at any point during the next dt seconds,
+// however fast they move. If they do, sets toi to when they first touch, in
+// seconds from now.
+bool sweptCollide(const game::Body& a, const game::Body& b, const float dt,
+                  float* toi);
 
 }  // namespace phys
 }  // namespace spacefight
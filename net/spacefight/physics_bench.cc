@@ -0,0 +1,129 @@
+#include "net/spacefight/physics.h"
+
+#include <random>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "net/spacefight/elements.h"
+#include "proto/spacefight/spacefight.pb.h"
+
+namespace spacefight {
+namespace phys {
+namespace {
+
+static constexpr float kDt = settings::step_seconds;
+// pairs tested per iteration, cycling through them so branches are not
+// predictable
+static constexpr int kPairs = 1024;
+
+// a moving box, unpacked from a body
+struct Mover {
+  AABB box;
+  float dx;
+  float dy;
+};
+
+// kPairs of bullets and ships close enough that about half of them collide
+struct Pairs {
+  std::vector<game::Body> bullets;
+  std::vector<game::Body> ships;
+  std::vector<Mover> bullet_movers;
+  std::vector<Mover> ship_movers;
+
+  Pairs() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> pos(-40, 40);
+    std::uniform_real_distribution<float> ship_vel(-ships::max_vel,
+                                                   ships::max_vel);
+    std::uniform_real_distribution<float> bullet_vel(
+        -bullets::vel - ships::max_vel, bullets::vel + ships::max_vel);
+    for (int i = 0; i < kPairs; i++) {
+      add(&bullets, &bullet_movers, pos(rng), pos(rng), bullet_vel(rng),
+          bullet_vel(rng), bullets::size);
+      add(&ships, &ship_movers, 0, 0, ship_vel(rng), ship_vel(rng),
+          ships::size);
+    }
+  }
+
+  static void add(std::vector<game::Body>* bodies,
+                  std::vector<Mover>* movers, const float x, const float y,
+                  const float dx, const float dy, const float size) {
+    game::Body body;
+    set(body.mutable_phys(), x, y, dx, dy);
+    set(body.mutable_size(), size, size);
+    bodies->push_back(body);
+    movers->push_back(
+        Mover{AABB{x, y, x + size, y + size}, dx * kDt, dy * kDt});
+  }
+};
+
+// the current test: the boxes where the bodies will be after the step
+void BM_WillCollide(benchmark::State& state) {
+  Pairs pairs;
+  int64_t hits = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kPairs; i++) {
+      hits += willCollide(pairs.bullets[i], pairs.ships[i], kDt);
+    }
+  }
+  benchmark::DoNotOptimize(hits);
+  state.SetItemsProcessed(state.iterations() * kPairs);
+}
+BENCHMARK(BM_WillCollide);
+
+void BM_SweptCollide(benchmark::State& state) {
+  Pairs pairs;
+  int64_t hits = 0;
+  float toi;
+  for (auto _ : state) {
+    for (int i = 0; i < kPairs; i++) {
+      hits += sweptCollide(pairs.bullets[i], pairs.ships[i], kDt, &toi);
+    }
+  }
+  benchmark::DoNotOptimize(hits);
+  state.SetItemsProcessed(state.iterations() * kPairs);
+}
+BENCHMARK(BM_SweptCollide);
+
+// what the game does, on boxes already unpacked from Bodies
+void BM_Intersects(benchmark::State& state) {
+  Pairs pairs;
+  int64_t hits = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kPairs; i++) {
+      const Mover& a = pairs.bullet_movers[i];
+      const Mover& b = pairs.ship_movers[i];
+      hits += intersects(
+          AABB{a.box.x1 + a.dx, a.box.y1 + a.dy, a.box.x2 + a.dx,
+               a.box.y2 + a.dy},
+          AABB{b.box.x1 + b.dx, b.box.y1 + b.dy, b.box.x2 + b.dx,
+               b.box.y2 + b.dy});
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * kPairs);
+}
+BENCHMARK(BM_Intersects);
+
+void BM_Sweep(benchmark::State& state) {
+  Pairs pairs;
+  int64_t hits = 0;
+  float toi;
+  for (auto _ : state) {
+    for (int i = 0; i < kPairs; i++) {
+      const Mover& a = pairs.bullet_movers[i];
+      const Mover& b = pairs.ship_movers[i];
+      hits += sweep(a.box, a.dx, a.dy, b.box, b.dx, b.dy, &toi);
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * kPairs);
+  state.counters["hit_percent"] = benchmark::Counter(
+      100.0 * hits / kPairs, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Sweep);
+
+}  // namespace
+}  // namespace phys
+}  // namespace spacefight
+
+BENCHMARK_MAIN();
@@ -0,0 +1,124 @@
+#include "net/spacefight/physics.h"
+
+#include <cmath>
+#include "gtest/gtest.h"
+
+namespace spacefight {
+namespace phys {
+namespace {
+
+TEST(PhysicsTest, RotationMatchesAngle) {
+  for (float radians : {0.0f, 0.1f, -0.1f, 1.5f, 3.0f, -2.5f}) {
+    float x = 3;
+    float y = -4;
+    float ex = x;
+    float ey = y;
+    rotate(&x, &y, rotation(radians));
+    float length = std::hypot(ex, ey);
+    float to = angle(ex, ey) + radians;
+    EXPECT_NEAR(x, length * std::cos(to), 1e-5) << radians;
+    EXPECT_NEAR(y, length * std::sin(to), 1e-5) << radians;
+  }
+}
+
+TEST(PhysicsTest, InverseUndoesRotation) {
+  Rotation r = rotation(0.3f);
+  float x = 2;
+  float y = 5;
+  rotate(&x, &y, r);
+  rotate(&x, &y, inverse(r));
+  EXPECT_NEAR(x, 2, 1e-5);
+  EXPECT_NEAR(y, 5, 1e-5);
+}
+
+TEST(PhysicsTest, RotationOfVectorFacesItsAngle) {
+  for (float radians : {0.0f, 0.7f, -1.2f, 2.9f}) {
+    Rotation r = rotation(10 * std::cos(radians), 10 * std::sin(radians));
+    Rotation e = rotation(radians);
+    EXPECT_NEAR(r.c, e.c, 1e-5) << radians;
+    EXPECT_NEAR(r.s, e.s, 1e-5) << radians;
+  }
+}
+
+TEST(PhysicsTest, DirectionOfZeroFacesAngleZero) {
+  float ux, uy;
+  direction(0, 0, &ux, &uy);
+  EXPECT_EQ(ux, 1);
+  EXPECT_EQ(uy, 0);
+  // the same way rotating by the angle of a zero vector faces
+  float x = 1;
+  float y = 0;
+  rotate(&x, &y, angle(0, 0));
+  EXPECT_EQ(x, ux);
+  EXPECT_EQ(y, uy);
+}
+
+TEST(PhysicsTest, SweptBoundsCoverStartAndEnd) {
+  AABB swept = sweptBounds(AABB{0, 0, 10, 10}, 25, -5);
+  EXPECT_EQ(swept.x1, 0);
+  EXPECT_EQ(swept.y1, -5);
+  EXPECT_EQ(swept.x2, 35);
+  EXPECT_EQ(swept.y2, 10);
+}
+
+TEST(PhysicsTest, SweepFindsTimeOfImpact) {
+  float toi = -1;
+  // a closes the 10 unit gap at 40 units per interval
+  ASSERT_TRUE(sweep(AABB{0, 0, 10, 10}, 40, 0, AABB{20, 0, 30, 10}, 0, 0,
+                    &toi));
+  EXPECT_FLOAT_EQ(toi, 0.25f);
+  // the same when b moves towards a instead
+  ASSERT_TRUE(sweep(AABB{0, 0, 10, 10}, 0, 0, AABB{20, 0, 30, 10}, -40, 0,
+                    &toi));
+  EXPECT_FLOAT_EQ(toi, 0.25f);
+  // boxes that already overlap touch straight away
+  ASSERT_TRUE(sweep(AABB{0, 0, 10, 10}, 5, 5, AABB{5, 5, 15, 15}, 0, 0,
+                    &toi));
+  EXPECT_EQ(toi, 0);
+  // touching edges count, at the very end of the interval
+  ASSERT_TRUE(sweep(AABB{0, 0, 10, 10}, 10, 0, AABB{20, 0, 30, 10}, 0, 0,
+                    &toi));
+  EXPECT_FLOAT_EQ(toi, 1);
+}
+
+TEST(PhysicsTest, SweepMisses) {
+  float toi;
+  // too slow to get there
+  EXPECT_FALSE(
+      sweep(AABB{0, 0, 10, 10}, 5, 0, AABB{20, 0, 30, 10}, 0, 0, &toi));
+  // moving away
+  EXPECT_FALSE(
+      sweep(AABB{0, 0, 10, 10}, -50, 0, AABB{20, 0, 30, 10}, 0, 0, &toi));
+  // passing above
+  EXPECT_FALSE(
+      sweep(AABB{0, 20, 10, 30}, 50, 0, AABB{20, 0, 30, 10}, 0, 0, &toi));
+  // crossing where b was, after b has left
+  EXPECT_FALSE(
+      sweep(AABB{0, 0, 2, 2}, 40, 40, AABB{18, 18, 22, 22}, 0, 40, &toi));
+}
+
+TEST(PhysicsTest, SweptCollideCatchesTunnelling) {
+  // a 7 unit bullet that jumps clean over a 20 unit ship in one step
+  game::Body bullet;
+  set(bullet.mutable_phys(), 0, 5, 1000, 0);
+  set(bullet.mutable_size(), 7, 7);
+  game::Body ship;
+  set(ship.mutable_phys(), 20, 0, 0, 0);
+  set(ship.mutable_size(), 20, 20);
+  const float dt = 0.05f;
+  ASSERT_FALSE(willCollide(bullet, ship, dt));
+
+  float toi;
+  ASSERT_TRUE(sweptCollide(bullet, ship, dt, &toi));
+  // the bullet's front edge reaches the ship after 13 units
+  EXPECT_NEAR(toi, 0.013f, 1e-6);
+}
+
+}  // namespace
+}  // namespace phys
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
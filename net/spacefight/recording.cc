@@ -0,0 +1,248 @@
+#include "net/spacefight/recording.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <cstring>
+#include "hoist/logging.h"
+#include "hoist/status_macros.h"
+
+namespace spacefight {
+
+namespace {
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using util::memfile::MemFile;
+
+// every recording starts with these bytes, the last is the format version
+constexpr char kMagic[] = {'S', 'F', 'R', 'C', 2};
+// size of a new recording, which doubles whenever it fills up
+constexpr size_t kInitialSize = 1 << 20;
+// upper bound of the bytes needed for a record, besides its strings
+constexpr size_t kMaxFixedBytes = 64;
+
+enum ControlBits : uint8_t {
+  kRotateLeft = 1 << 0,
+  kRotateRight = 1 << 1,
+  kThrust = 1 << 2,
+  kFire = 1 << 3,
+};
+
+uint8_t packControls(const Controls& controls) {
+  return (controls.rotate_left ? kRotateLeft : 0) |
+         (controls.rotate_right ? kRotateRight : 0) |
+         (controls.thrust ? kThrust : 0) | (controls.fire ? kFire : 0);
+}
+
+Controls unpackControls(const uint8_t bits) {
+  Controls controls;
+  controls.rotate_left = bits & kRotateLeft;
+  controls.rotate_right = bits & kRotateRight;
+  controls.thrust = bits & kThrust;
+  controls.fire = bits & kFire;
+  return controls;
+}
+
+uint8_t* writeFloat(const float value, uint8_t* target) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return CodedOutputStream::WriteLittleEndian32ToArray(bits, target);
+}
+
+bool readFloat(CodedInputStream* input, float* value) {
+  uint32_t bits;
+  if (!input->ReadLittleEndian32(&bits)) {
+    return false;
+  }
+  std::memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+bool readControls(CodedInputStream* input, Controls* controls) {
+  uint32_t bits;
+  if (!input->ReadVarint32(&bits)) {
+    return false;
+  }
+  *controls = unpackControls(bits);
+  return true;
+}
+
+bool readString(CodedInputStream* input, std::string* s) {
+  uint32_t size;
+  return input->ReadVarint32(&size) && input->ReadString(s, size);
+}
+
+}  // namespace
+
+// Recorder {
+
+Hoist::StatusOr<Recorder*> Recorder::open(const std::string& path) {
+  std::unique_ptr<MemFile> file(new MemFile(path));
+  RETURN_IF_ERROR(file->Resize(kInitialSize));
+  // start from scratch, even if the file already had a recording
+  std::memset(file->Data(), 0, file->Size());
+  std::memcpy(file->Data(), kMagic, sizeof(kMagic));
+  return new Recorder(file.release());
+}
+
+Recorder::Recorder(MemFile* file)
+    : file_(file), offset_(sizeof(kMagic)), failed_(false) {}
+
+Recorder::~Recorder() {
+  if (file_ != nullptr) {
+    close();
+  }
+}
+
+bool Recorder::reserve(const size_t bytes) {
+  if (offset_ + bytes <= file_->Size()) {
+    return true;
+  }
+  size_t size = file_->Size();
+  while (offset_ + bytes > size) {
+    size *= 2;
+  }
+  Hoist::Status status = file_->ResizeMinimum(size);
+  if (!status.ok()) {
+    ELOG("recording stopped, could not grow " << file_->Path() << ": "
+                                              << status);
+    return false;
+  }
+  return true;
+}
+
+void Recorder::write(const Record& record) {
+  const size_t bytes =
+      kMaxFixedBytes + record.token.size() + record.username.size();
+  if (failed_ || !reserve(bytes)) {
+    failed_ = true;
+    return;
+  }
+  uint8_t* start = static_cast<uint8_t*>(file_->DataAt(offset_));
+  uint8_t* target = start;
+  *target++ = record.type;
+  switch (record.type) {
+    case Record::kHeader:
+      target = CodedOutputStream::WriteVarint64ToArray(record.seed, target);
+      target = CodedOutputStream::WriteVarint32ToArray(record.bots, target);
+      break;
+    case Record::kJoin:
+      target =
+          CodedOutputStream::WriteVarint64ToArray(record.player_id, target);
+      target = CodedOutputStream::WriteStringWithSizeToArray(record.token,
+                                                             target);
+      target = CodedOutputStream::WriteStringWithSizeToArray(record.username,
+                                                             target);
+      *target++ = packControls(record.controls);
+      break;
+    case Record::kInput:
+      target =
+          CodedOutputStream::WriteVarint64ToArray(record.player_id, target);
+      *target++ = packControls(record.controls);
+      break;
+    case Record::kQuit:
+      target = CodedOutputStream::WriteStringWithSizeToArray(record.token,
+                                                             target);
+      break;
+    case Record::kStep:
+      target = writeFloat(record.dt, target);
+      break;
+    case Record::kPublish:
+    case Record::kEnd:
+      break;
+  }
+  offset_ += target - start;
+}
+
+Hoist::Status Recorder::close() {
+  if (file_ == nullptr) {
+    return Hoist::Status::OK;
+  }
+  Hoist::Status status = file_->Resize(offset_);
+  if (status.ok()) {
+    status = file_->Close();
+  }
+  file_.reset();
+  return status;
+}
+
+// } Recorder
+
+// RecordReader {
+
+Hoist::StatusOr<RecordReader*> RecordReader::open(const std::string& path) {
+  ASSIGN_OR_RETURN(MemFile * file, MemFile::OpenExistingMemFile(path));
+  if (file->Size() < sizeof(kMagic) ||
+      std::memcmp(file->Data(), kMagic, sizeof(kMagic)) != 0) {
+    delete file;
+    return Hoist::Status(Hoist::error::INVALID_ARGUMENT,
+                         "not a spacefight recording");
+  }
+  return new RecordReader(file);
+}
+
+RecordReader::RecordReader(MemFile* file)
+    : file_(file), offset_(sizeof(kMagic)), ok_(true) {}
+
+bool RecordReader::next(Record* record) {
+  if (!ok_ || offset_ >= file_->Size()) {
+    return false;
+  }
+  CodedInputStream input(static_cast<const uint8_t*>(file_->DataAt(offset_)),
+                         file_->Size() - offset_);
+  uint32_t type;
+  if (!input.ReadVarint32(&type)) {
+    ok_ = false;
+    return false;
+  }
+  record->type = static_cast<Record::Type>(type);
+  bool read = true;
+  switch (record->type) {
+    case Record::kEnd:
+      // the rest of the file was never written to
+      return false;
+    case Record::kHeader: {
+      uint32_t bots = 0;
+      read = input.ReadVarint64(&record->seed) && input.ReadVarint32(&bots);
+      record->bots = bots;
+      break;
+    }
+    case Record::kJoin: {
+      uint64_t player_id = 0;
+      read = input.ReadVarint64(&player_id) &&
+             readString(&input, &record->token) &&
+             readString(&input, &record->username) &&
+             readControls(&input, &record->controls);
+      record->player_id = player_id;
+      break;
+    }
+    case Record::kInput: {
+      uint64_t player_id = 0;
+      read = input.ReadVarint64(&player_id) &&
+             readControls(&input, &record->controls);
+      record->player_id = player_id;
+      break;
+    }
+    case Record::kQuit:
+      read = readString(&input, &record->token);
+      break;
+    case Record::kStep:
+      read = readFloat(&input, &record->dt);
+      break;
+    case Record::kPublish:
+      break;
+    default:
+      read = false;
+      break;
+  }
+  if (!read) {
+    ELOG("malformed record at offset " << offset_);
+    ok_ = false;
+    return false;
+  }
+  offset_ += input.CurrentPosition();
+  return true;
+}
+
+// } RecordReader
+
+}  // namespace spacefight
@@ -0,0 +1,106 @@
+#ifndef NET_SPACEFIGHT_RECORDING_H
+#define NET_SPACEFIGHT_RECORDING_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "hoist/statusor.h"
+#include "net/spacefight/entities.h"
+#include "util/memfile/memfile.h"
+
+namespace spacefight {
+
+// Recordings are an append-only log of everything that changes a game, so
+// that a match can be replayed exactly, as fast as possible.
+//
+// A game is rebuilt from the seed and number of bots in its header, then
+// every record is applied in order. Records only describe what the game did
+// with its input, not the world itself, so the log stays small.
+
+// Record is one entry in a recording.
+struct Record {
+  enum Type : uint8_t {
+    // the rest of the log is unused
+    kEnd = 0,
+    // how the game was created, always the first record
+    kHeader = 1,
+    // a player joined, with player_id, token, username and controls
+    kJoin = 2,
+    // a player's controls changed, with player_id and controls
+    kInput = 3,
+    // a player quit, with token
+    kQuit = 4,
+    // the world moved forward one step of dt seconds
+    kStep = 5,
+    // a snapshot of the world was published
+    kPublish = 6,
+  };
+
+  Type type;
+  // kHeader
+  uint64_t seed;
+  int32_t bots;
+  // kJoin and kInput
+  int64_t player_id;
+  // kJoin and kQuit
+  std::string token;
+  // kJoin
+  std::string username;
+  // kJoin and kInput
+  Controls controls;
+  // kStep
+  float dt;
+};
+
+// Recorder appends records to a file.
+// A recorder is not thread safe, the game only records while locked.
+class Recorder final {
+ public:
+  static Hoist::StatusOr<Recorder*> open(const std::string& path);
+
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+  ~Recorder();
+
+  void write(const Record& record);
+
+  // trim the file to what was written and close it
+  Hoist::Status close();
+
+ private:
+  explicit Recorder(util::memfile::MemFile* file);
+
+  // make room for at least this many more bytes
+  bool reserve(const size_t bytes);
+
+  std::unique_ptr<util::memfile::MemFile> file_;
+  // where the next record goes
+  size_t offset_;
+  // whether a write failed, after which nothing more is recorded
+  bool failed_;
+};
+
+// RecordReader reads the records in a file in order.
+class RecordReader final {
+ public:
+  static Hoist::StatusOr<RecordReader*> open(const std::string& path);
+
+  RecordReader(const RecordReader&) = delete;
+  RecordReader& operator=(const RecordReader&) = delete;
+
+  // read the next record, returning false at the end of the recording
+  bool next(Record* record);
+  // whether everything read so far was well formed
+  bool ok() const { return ok_; }
+
+ private:
+  explicit RecordReader(util::memfile::MemFile* file);
+
+  std::unique_ptr<util::memfile::MemFile> file_;
+  size_t offset_;
+  bool ok_;
+};
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,181 @@
+#include "net/spacefight/recording.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "hoist/clock.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/game.h"
+
+namespace spacefight {
+namespace {
+
+static const std::string kPath = "/tmp/spacefight_recording_test";
+
+static constexpr Hoist::nanos_t kTick =
+    std::chrono::nanoseconds(settings::game_update_interval).count();
+
+class RecordingTest : public ::testing::Test {
+ protected:
+  void TearDown() override { unlink(kPath.c_str()); }
+
+  std::unique_ptr<Recorder> openRecorder() {
+    auto recorder = Recorder::open(kPath);
+    EXPECT_TRUE(recorder.ok()) << recorder.status();
+    return std::unique_ptr<Recorder>(recorder.ValueOrDie());
+  }
+
+  std::unique_ptr<RecordReader> openReader() {
+    auto reader = RecordReader::open(kPath);
+    EXPECT_TRUE(reader.ok()) << reader.status();
+    return std::unique_ptr<RecordReader>(reader.ValueOrDie());
+  }
+};
+
+TEST_F(RecordingTest, ReadsWhatWasWritten) {
+  std::unique_ptr<Recorder> recorder = openRecorder();
+  Record header{Record::kHeader};
+  header.seed = 1ULL << 60;
+  header.bots = 3;
+  recorder->write(header);
+  Record join{Record::kJoin};
+  join.player_id = 7;
+  join.token = "token";
+  join.username = "pilot";
+  join.controls.thrust = true;
+  recorder->write(join);
+  Record input{Record::kInput};
+  input.player_id = 300;
+  input.controls.fire = true;
+  input.controls.rotate_left = true;
+  recorder->write(input);
+  Record step{Record::kStep};
+  step.dt = 0.026f;
+  recorder->write(step);
+  recorder->write(Record{Record::kPublish});
+  Record quit{Record::kQuit};
+  quit.token = "token";
+  recorder->write(quit);
+  ASSERT_TRUE(recorder->close().ok());
+
+  std::unique_ptr<RecordReader> reader = openReader();
+  Record record;
+  ASSERT_TRUE(reader->next(&record));
+  EXPECT_EQ(record.type, Record::kHeader);
+  EXPECT_EQ(record.seed, 1ULL << 60);
+  EXPECT_EQ(record.bots, 3);
+  ASSERT_TRUE(reader->next(&record));
+  EXPECT_EQ(record.type, Record::kJoin);
+  EXPECT_EQ(record.player_id, 7);
+  EXPECT_EQ(record.token, "token");
+  EXPECT_EQ(record.username, "pilot");
+  EXPECT_TRUE(record.controls.thrust);
+  EXPECT_FALSE(record.controls.fire);
+  ASSERT_TRUE(reader->next(&record));
+  EXPECT_EQ(record.type, Record::kInput);
+  EXPECT_EQ(record.player_id, 300);
+  EXPECT_TRUE(record.controls.fire);
+  EXPECT_TRUE(record.controls.rotate_left);
+  EXPECT_FALSE(record.controls.thrust);
+  ASSERT_TRUE(reader->next(&record));
+  EXPECT_EQ(record.type, Record::kStep);
+  EXPECT_EQ(record.dt, 0.026f);
+  ASSERT_TRUE(reader->next(&record));
+  EXPECT_EQ(record.type, Record::kPublish);
+  ASSERT_TRUE(reader->next(&record));
+  EXPECT_EQ(record.type, Record::kQuit);
+  EXPECT_EQ(record.token, "token");
+  EXPECT_FALSE(reader->next(&record));
+  EXPECT_TRUE(reader->ok());
+}
+
+TEST_F(RecordingTest, GrowsPastItsFirstBlock) {
+  std::unique_ptr<Recorder> recorder = openRecorder();
+  Record step{Record::kStep};
+  step.dt = 1;
+  for (int i = 0; i < 1000000; i++) {
+    recorder->write(step);
+  }
+  ASSERT_TRUE(recorder->close().ok());
+
+  std::unique_ptr<RecordReader> reader = openReader();
+  Record record;
+  int steps = 0;
+  while (reader->next(&record)) {
+    steps++;
+  }
+  EXPECT_TRUE(reader->ok());
+  EXPECT_EQ(steps, 1000000);
+}
+
+TEST_F(RecordingTest, ReplaysTheSameGame) {
+  auto clock = std::make_shared<Hoist::ManualClock>();
+  std::string recorded;
+  {
+    Game game(clock, 4, 42);
+    game.record(openRecorder());
+    game.start(false);
+    PlayerInput input;
+    input.set_token("first");
+    input.set_username("first");
+    input.set_thrust(true);
+    game.createNewPlayer(&input);
+    input.set_token("second");
+    input.set_username("second");
+    game.createNewPlayer(&input);
+    for (int tick = 0; tick < 500; tick++) {
+      if (tick % 20 == 0) {
+        input.set_token("first");
+        input.set_fire(!input.fire());
+        input.set_rotate_left(tick % 40 == 0);
+        game.apply(&input);
+      }
+      // a burst of queued joins, admitted over the following steps
+      if (tick == 100) {
+        PlayerInput joining;
+        for (int i = 0; i < 100; i++) {
+          joining.set_token("joining" + std::to_string(i));
+          joining.set_username("joining" + std::to_string(i));
+          game.join(&joining);
+        }
+      }
+      if (tick == 300) {
+        input.set_token("second");
+        input.set_quit(true);
+        game.apply(&input);
+        input.set_quit(false);
+      }
+      // sometimes catch up on more than one step
+      clock->advance(tick % 7 == 0 ? 2 * kTick : kTick);
+      game.update();
+    }
+    recorded = game.getSnapshot()->world.SerializeAsString();
+    game.end();
+  }
+
+  std::unique_ptr<RecordReader> reader = openReader();
+  Record record;
+  ASSERT_TRUE(reader->next(&record));
+  ASSERT_EQ(record.type, Record::kHeader);
+  Game game(std::make_shared<Hoist::ManualClock>(), record.bots, record.seed);
+  game.start(false);
+  while (reader->next(&record)) {
+    game.replay(record);
+  }
+  EXPECT_TRUE(reader->ok());
+  std::shared_ptr<const Snapshot> snapshot = game.getSnapshot();
+  EXPECT_EQ(snapshot->world.players_size(), 105);
+  EXPECT_GT(snapshot->world.bullets_size(), 0);
+  EXPECT_EQ(snapshot->world.SerializeAsString(), recorded);
+  game.end();
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,81 @@
+// Replay a recorded spacefight game as fast as possible, to profile it.
+// usage:
+//  ./replay path [n]   replay the recording made by ./server --record path,
+//                      splitting each step across n threads
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include "hoist/clock.h"
+#include "hoist/init.h"
+#include "hoist/logging.h"
+#include "net/spacefight/game.h"
+#include "net/spacefight/recording.h"
+
+// print the average of a total over some count
+void printAverage(const char *name, Hoist::nanos_t total, int64_t count) {
+  std::cout << "  " << name << ": " << (count == 0 ? 0 : total / count)
+            << "ns" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+  Hoist::Init();
+
+  int threads = argc == 3 ? std::atoi(argv[2]) : 1;
+  if (argc < 2 || argc > 3 || threads < 1) {
+    std::cout << "Usage: \n" << argv[0] << " path [threads]" << std::endl;
+    return 1;
+  }
+
+  auto opened = spacefight::RecordReader::open(argv[1]);
+  if (!opened.ok()) {
+    ELOG("cannot replay " << argv[1] << ": " << opened.status());
+    return 1;
+  }
+  std::unique_ptr<spacefight::RecordReader> reader(opened.ValueOrDie());
+
+  spacefight::Record record;
+  if (!reader->next(&record) || record.type != spacefight::Record::kHeader) {
+    ELOG(argv[1] << " has no header");
+    return 1;
+  }
+
+  // the clock never moves, every step comes from the recording
+  spacefight::Game game(std::make_shared<Hoist::ManualClock>(), record.bots,
+                        record.seed);
+  game.setTickThreads(threads);
+  game.start(false);
+
+  int64_t records = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (reader->next(&record)) {
+    game.replay(record);
+    records++;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  game.end();
+
+  if (!reader->ok()) {
+    ELOG(argv[1] << " is corrupt, stopped after " << records << " records");
+  }
+
+  spacefight::PhaseTimes times = game.phaseTimes();
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  std::cout << "replayed " << records << " records, " << times.steps
+            << " steps in " << seconds << "s ("
+            << (seconds > 0 ? times.steps / seconds : 0) << " steps/s)"
+            << std::endl;
+  std::cout << "average time per step:" << std::endl;
+  printAverage("inputs", times.inputs, times.steps);
+  printAverage("bullet_collisions", times.bullet_collisions, times.steps);
+  printAverage("ships", times.ships, times.steps);
+  printAverage("bullets", times.bullets, times.steps);
+  printAverage("explosions", times.explosions, times.steps);
+  printAverage("ai", times.ai, times.steps);
+  std::cout << "average time per snapshot:" << std::endl;
+  printAverage("snapshot", times.snapshot, times.snapshots);
+
+  google::protobuf::ShutdownProtobufLibrary();
+  return reader->ok() ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#include "net/spacefight/rooms.h"
+
+#include <algorithm>
+#include "hoist/logging.h"
+
+namespace spacefight {
+
+RoomManager::RoomManager(const RoomOptions& options,
+                         std::unique_ptr<Recorder> recorder)
+    : options_(options) {
+  rooms_.push_back(newRoom(kDefaultRoom, 0));
+  default_room_ = rooms_.front().get();
+  if (recorder) {
+    default_room_->game.record(std::move(recorder));
+  }
+  default_room_->game.start();
+}
+
+RoomManager::~RoomManager() {
+  for (std::shared_ptr<Room>& room : rooms_) {
+    if (room) {
+      room->game.end();
+    }
+  }
+}
+
+bool RoomManager::login(const Registration& request, Token* response) {
+  std::shared_ptr<Room> room;
+  {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    room = findOrCreateUnlocked(request.room().empty() ? kDefaultRoom
+                                                       : request.room());
+    if (room == nullptr) {
+      WLOG("no room for " << request.room() << ", already hosting "
+                          << options_.max_rooms);
+      return false;
+    }
+    // the room stays open while the player logs in
+    room->players++;
+  }
+  room->sessions.login(request, response);
+  response->set_room(room->name);
+  std::scoped_lock<std::mutex> lock(mutex_);
+  tokens_[response->token()] = room;
+  return true;
+}
+
+Hoist::StatusOr<std::shared_ptr<Room>> RoomManager::find(
+    const std::string& token) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  auto search = tokens_.find(token);
+  if (search == tokens_.end()) {
+    return Hoist::Status(Hoist::error::NOT_FOUND, "no player with that token");
+  }
+  return search->second;
+}
+
+std::shared_ptr<Room> RoomManager::leave(const std::string& token) {
+  std::shared_ptr<Room> closed;
+  {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    auto search = tokens_.find(token);
+    if (search == tokens_.end()) {
+      return nullptr;
+    }
+    std::shared_ptr<Room> room = std::move(search->second);
+    tokens_.erase(search);
+    if (--room->players > 0 || room.get() == default_room_) {
+      return nullptr;
+    }
+    for (std::shared_ptr<Room>& slot : rooms_) {
+      if (slot == room) {
+        slot.reset();
+      }
+    }
+    closed = std::move(room);
+    while (!rooms_.back()) {
+      rooms_.pop_back();
+    }
+  }
+  closed->game.end();
+  ILOG("closed room " << closed->name);
+  return closed;
+}
+
+size_t RoomManager::size() const {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  size_t open = 0;
+  for (const std::shared_ptr<Room>& room : rooms_) {
+    open += room != nullptr;
+  }
+  return open;
+}
+
+void RoomManager::toProto(statusz::Status* status) const {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  default_room_->game.tickStats().toProto(status->mutable_ticks());
+  for (const std::shared_ptr<Room>& room : rooms_) {
+    if (room) {
+      room->game.tickStats().toProto(&(*status->mutable_rooms())[room->name]);
+    }
+  }
+}
+
+std::shared_ptr<Room> RoomManager::findOrCreateUnlocked(
+    const std::string& name) {
+  // the first free slot, every slot before it holds a room
+  size_t free = rooms_.size();
+  for (size_t slot = 0; slot < rooms_.size(); slot++) {
+    if (!rooms_[slot]) {
+      free = std::min(free, slot);
+    } else if (rooms_[slot]->name == name) {
+      return rooms_[slot];
+    }
+  }
+  if (static_cast<int>(free) >= options_.max_rooms) {
+    return nullptr;
+  }
+  if (free == rooms_.size()) {
+    rooms_.emplace_back();
+  }
+  rooms_[free] = newRoom(name, free);
+  std::shared_ptr<Room> room = rooms_[free];
+  room->game.start();
+  ILOG("opened room " << name << " in slot " << free);
+  return room;
+}
+
+std::unique_ptr<Room> RoomManager::newRoom(const std::string& name,
+                                           const size_t slot) const {
+  std::shared_ptr<Hoist::Clock> clock =
+      options_.clock ? options_.clock : std::make_shared<Hoist::SystemClock>();
+  std::unique_ptr<Room> room(new Room(name, clock, options_.bots));
+  room->game.setTickThreads(options_.tick_threads);
+  if (options_.pin) {
+    // one room per cpu, by slot, until they wrap around
+    room->game.pinUpdateThread(static_cast<int>(slot));
+  }
+  return room;
+}
+
+}  // namespace spacefight
@@ -0,0 +1,111 @@
+#ifndef NET_SPACEFIGHT_ROOMS_H
+#define NET_SPACEFIGHT_ROOMS_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "hoist/clock.h"
+#include "hoist/statusor.h"
+#include "net/spacefight/game.h"
+#include "net/spacefight/recording.h"
+#include "net/spacefight/sessions.h"
+#include "proto/spacefight/spacefight_service.pb.h"
+#include "proto/statusz/statusz.pb.h"
+
+namespace spacefight {
+
+// RoomOptions say how the rooms of a RoomManager are set up.
+struct RoomOptions {
+  // most rooms hosted at once, including the default room
+  int max_rooms = 1;
+  // bots in every room
+  int bots = 4;
+  // threads each step of a room is split across
+  int tick_threads = 1;
+  // pin the update thread of each room to a cpu, spreading rooms over cpus
+  bool pin = false;
+  // the clock every room runs on, the system clock if null
+  std::shared_ptr<Hoist::Clock> clock;
+};
+
+// Room is one game, and the sessions of the players in it.
+struct Room {
+  Room(const std::string& name, std::shared_ptr<Hoist::Clock> clock,
+       const int bots)
+      : name(name), game(clock, bots), sessions(game) {}
+
+  Room(const Room&) = delete;
+  Room& operator=(const Room&) = delete;
+
+  const std::string name;
+  Game game;
+  Sessions sessions;
+  // players logged in and not yet left, counted by the RoomManager
+  int players = 0;
+};
+
+// RoomManager hosts independent games, called rooms, in one process.
+//
+// Every room runs on its own update thread, so rooms tick in parallel. A
+// room is created the first time a player asks for it, and is closed when
+// its last player leaves, freeing its place for another. The default room
+// lives as long as the manager. Safe to use from any number of threads.
+class RoomManager final {
+ public:
+  // name of the room players join unless they ask for another
+  static constexpr const char* kDefaultRoom = "default";
+
+  // Create and start the default room, recording it if there is a recorder.
+  explicit RoomManager(const RoomOptions& options,
+                       std::unique_ptr<Recorder> recorder = nullptr);
+  // end every room
+  ~RoomManager();
+
+  RoomManager(const RoomManager&) = delete;
+  RoomManager& operator=(const RoomManager&) = delete;
+
+  // Create a player in the room they asked for, creating the room if need
+  // be. Returns false if there is no such room and no room for another.
+  bool login(const Registration& request, Token* response);
+
+  // get the room of the player with a token, or NOT_FOUND if the token
+  // belongs to no one. the room is valid for as long as it is held.
+  Hoist::StatusOr<std::shared_ptr<Room>> find(const std::string& token);
+
+  // forget the token of a player whose stream has ended, and close their
+  // room if they were the last to leave it. returns the room if it closed,
+  // so whatever serves the room can stop.
+  std::shared_ptr<Room> leave(const std::string& token);
+
+  Room& defaultRoom() { return *default_room_; }
+
+  // get the number of rooms
+  size_t size() const;
+
+  // write the tick stats of every room, and of the default room as the
+  // status of the process as a whole
+  void toProto(statusz::Status* status) const;
+
+ private:
+  // get a room by name, creating and starting it if there is space.
+  // returns null if there is no such room and no space for it.
+  std::shared_ptr<Room> findOrCreateUnlocked(const std::string& name);
+  // create a room as the options say, without starting it
+  std::unique_ptr<Room> newRoom(const std::string& name,
+                                const size_t slot) const;
+
+  const RoomOptions options_;
+  Room* default_room_;
+  mutable std::mutex mutex_;
+  // the open rooms, by slot, with null for free slots. a room's slot says
+  // which cpu it is pinned to, and the default room is in the first.
+  std::vector<std::shared_ptr<Room>> rooms_;
+  // the room of every player logged in, by token
+  std::unordered_map<std::string, std::shared_ptr<Room>> tokens_;
+};
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,137 @@
+#include "net/spacefight/rooms.h"
+
+#include <memory>
+#include "gtest/gtest.h"
+#include "hoist/clock.h"
+#include "hoist/statusor.h"
+#include "proto/spacefight/spacefight_service.pb.h"
+#include "proto/statusz/statusz.pb.h"
+
+namespace spacefight {
+namespace {
+
+RoomOptions options(const int max_rooms) {
+  RoomOptions options;
+  options.max_rooms = max_rooms;
+  options.bots = 0;
+  options.clock = std::make_shared<Hoist::ManualClock>();
+  return options;
+}
+
+Registration registration(const std::string& room) {
+  Registration registration;
+  registration.set_username("pilot");
+  registration.set_room(room);
+  return registration;
+}
+
+TEST(RoomManagerTest, JoinsTheDefaultRoom) {
+  RoomManager rooms(options(1));
+  Token token;
+  ASSERT_TRUE(rooms.login(registration(""), &token));
+  EXPECT_EQ(RoomManager::kDefaultRoom, token.room());
+  EXPECT_EQ(&rooms.defaultRoom(),
+            rooms.find(token.token()).ValueOrDie().get());
+}
+
+TEST(RoomManagerTest, CreatesRoomsUpToTheLimit) {
+  RoomManager rooms(options(2));
+  Token first;
+  ASSERT_TRUE(rooms.login(registration("arena"), &first));
+  EXPECT_EQ("arena", first.room());
+  Token second;
+  ASSERT_TRUE(rooms.login(registration("arena"), &second));
+  EXPECT_EQ(2u, rooms.size());
+
+  Token full;
+  EXPECT_FALSE(rooms.login(registration("other"), &full));
+  EXPECT_EQ(2u, rooms.size());
+  // the default room is always there
+  EXPECT_TRUE(rooms.login(registration(RoomManager::kDefaultRoom), &full));
+}
+
+TEST(RoomManagerTest, FindsTheRoomOfEachPlayer) {
+  RoomManager rooms(options(3));
+  Token lobby, arena, other;
+  ASSERT_TRUE(rooms.login(registration(""), &lobby));
+  ASSERT_TRUE(rooms.login(registration("arena"), &arena));
+  ASSERT_TRUE(rooms.login(registration("other"), &other));
+
+  EXPECT_EQ(RoomManager::kDefaultRoom,
+            rooms.find(lobby.token()).ValueOrDie()->name);
+  EXPECT_EQ("arena", rooms.find(arena.token()).ValueOrDie()->name);
+  EXPECT_EQ("other", rooms.find(other.token()).ValueOrDie()->name);
+  // every room is its own game
+  EXPECT_NE(&rooms.find(arena.token()).ValueOrDie()->game,
+            &rooms.find(other.token()).ValueOrDie()->game);
+}
+
+TEST(RoomManagerTest, RejectsUnknownTokens) {
+  RoomManager rooms(options(2));
+  Token token;
+  ASSERT_TRUE(rooms.login(registration("arena"), &token));
+
+  Hoist::StatusOr<std::shared_ptr<Room>> nobody = rooms.find("nobody");
+  ASSERT_FALSE(nobody.ok());
+  EXPECT_EQ(Hoist::error::NOT_FOUND, nobody.status().error_code());
+
+  // a player's token is forgotten once they leave
+  rooms.leave(token.token());
+  EXPECT_FALSE(rooms.find(token.token()).ok());
+}
+
+TEST(RoomManagerTest, ClosesRoomsOnceEmpty) {
+  RoomManager rooms(options(2));
+  Token first, second;
+  ASSERT_TRUE(rooms.login(registration("arena"), &first));
+  ASSERT_TRUE(rooms.login(registration("arena"), &second));
+  std::shared_ptr<Room> arena = rooms.find(first.token()).ValueOrDie();
+
+  EXPECT_EQ(nullptr, rooms.leave(first.token()));
+  EXPECT_EQ(2u, rooms.size());
+  EXPECT_EQ(arena, rooms.leave(second.token()));
+  EXPECT_EQ(1u, rooms.size());
+  // its game has ended
+  EXPECT_EQ(nullptr, arena->game.waitForSnapshot(-1, 0));
+
+  // its place is free for another room
+  Token other;
+  ASSERT_TRUE(rooms.login(registration("other"), &other));
+  EXPECT_EQ(2u, rooms.size());
+  EXPECT_NE(arena, rooms.find(other.token()).ValueOrDie());
+  std::shared_ptr<Room> closed = rooms.leave(other.token());
+  ASSERT_NE(nullptr, closed);
+  EXPECT_EQ("other", closed->name);
+
+  // and a room of the same name is a new game
+  Token again;
+  ASSERT_TRUE(rooms.login(registration("arena"), &again));
+  EXPECT_NE(arena, rooms.find(again.token()).ValueOrDie());
+
+  // the default room stays open without players
+  Token lobby;
+  ASSERT_TRUE(rooms.login(registration(""), &lobby));
+  EXPECT_EQ(nullptr, rooms.leave(lobby.token()));
+  EXPECT_EQ(2u, rooms.size());
+}
+
+TEST(RoomManagerTest, ReportsEveryRoom) {
+  RoomManager rooms(options(2));
+  Token token;
+  ASSERT_TRUE(rooms.login(registration("arena"), &token));
+
+  statusz::Status status;
+  rooms.toProto(&status);
+  EXPECT_TRUE(status.has_ticks());
+  EXPECT_EQ(2, status.rooms_size());
+  EXPECT_EQ(1, status.rooms().count("arena"));
+  EXPECT_EQ(1, status.rooms().count(RoomManager::kDefaultRoom));
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,25 @@
+#include "net/spacefight/scheduler.h"
+
+namespace spacefight {
+
+void TickScheduler::reset(const Hoist::nanos_t now) {
+  deadline_ = now + period_;
+}
+
+int TickScheduler::advance(const Hoist::nanos_t now) {
+  if (now < deadline_) {
+    return 0;
+  }
+  int64_t owed = (now - deadline_) / period_ + 1;
+  deadline_ += owed * period_;
+  if (owed > 1) {
+    late_++;
+  }
+  if (owed > max_steps_) {
+    dropped_ += owed - max_steps_;
+    return max_steps_;
+  }
+  return static_cast<int>(owed);
+}
+
+}  // namespace spacefight
@@ -0,0 +1,48 @@
+#ifndef NET_SPACEFIGHT_SCHEDULER_H
+#define NET_SPACEFIGHT_SCHEDULER_H
+
+#include <cstdint>
+#include "hoist/clock.h"
+
+namespace spacefight {
+
+// TickScheduler decides how many fixed-length steps a simulation owes.
+//
+// Steps are due on absolute deadlines, start + n * period, so time spent
+// updating or oversleeping never pushes later steps back. When the caller
+// falls behind, every missed step is still run, up to max_steps at once.
+// Anything beyond that is dropped rather than letting the backlog grow.
+class TickScheduler final {
+ public:
+  TickScheduler(const Hoist::nanos_t period, const int max_steps)
+      : period_(period),
+        max_steps_(max_steps),
+        deadline_(0),
+        late_(0),
+        dropped_(0) {}
+
+  // restart the schedule, with the first step due one period after now
+  void reset(const Hoist::nanos_t now);
+
+  // count the steps due at a time and move the deadline past them
+  int advance(const Hoist::nanos_t now);
+
+  // when the next step is due
+  Hoist::nanos_t deadline() const { return deadline_; }
+
+  // number of advances that owed more than one step
+  int64_t late() const { return late_; }
+  // number of steps skipped because too many were owed at once
+  int64_t dropped() const { return dropped_; }
+
+ private:
+  const Hoist::nanos_t period_;
+  const int max_steps_;
+  Hoist::nanos_t deadline_;
+  int64_t late_;
+  int64_t dropped_;
+};
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,59 @@
+#include "net/spacefight/scheduler.h"
+
+#include "gtest/gtest.h"
+
+namespace spacefight {
+namespace {
+
+static constexpr Hoist::nanos_t kPeriod = 26000000;
+
+TEST(TickSchedulerTest, NothingDueBeforeDeadline) {
+  TickScheduler scheduler(kPeriod, 4);
+  scheduler.reset(1000);
+
+  EXPECT_EQ(1000 + kPeriod, scheduler.deadline());
+  EXPECT_EQ(0, scheduler.advance(1000 + kPeriod - 1));
+}
+
+TEST(TickSchedulerTest, DeadlinesDoNotDrift) {
+  TickScheduler scheduler(kPeriod, 4);
+  scheduler.reset(0);
+
+  // every wake up is a little late, the schedule stays on the period
+  for (int i = 1; i <= 100; i++) {
+    ASSERT_EQ(1, scheduler.advance(i * kPeriod + kPeriod / 3));
+    ASSERT_EQ((i + 1) * kPeriod, scheduler.deadline());
+  }
+  EXPECT_EQ(0, scheduler.late());
+  EXPECT_EQ(0, scheduler.dropped());
+}
+
+TEST(TickSchedulerTest, CatchesUpMissedSteps) {
+  TickScheduler scheduler(kPeriod, 4);
+  scheduler.reset(0);
+
+  EXPECT_EQ(3, scheduler.advance(3 * kPeriod + 5));
+  EXPECT_EQ(4 * kPeriod, scheduler.deadline());
+  EXPECT_EQ(1, scheduler.late());
+  EXPECT_EQ(0, scheduler.dropped());
+}
+
+TEST(TickSchedulerTest, CapsCatchUp) {
+  TickScheduler scheduler(kPeriod, 4);
+  scheduler.reset(0);
+
+  EXPECT_EQ(4, scheduler.advance(10 * kPeriod));
+  // the dropped steps are not owed later
+  EXPECT_EQ(11 * kPeriod, scheduler.deadline());
+  EXPECT_EQ(0, scheduler.advance(11 * kPeriod - 1));
+  EXPECT_EQ(1, scheduler.late());
+  EXPECT_EQ(6, scheduler.dropped());
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,70 @@
+#include "net/spacefight/send_rate.h"
+
+#include <algorithm>
+#include "net/spacefight/tick_stats.h"
+
+namespace spacefight {
+
+SendRate::SendRate(const Hoist::nanos_t fastest, const Hoist::nanos_t slowest)
+    : fastest_(fastest),
+      slowest_(std::max(fastest, slowest)),
+      stats_{0, 0, 0, 0, fastest},
+      writing_(false),
+      started_(0),
+      writes_(kWindow) {}
+
+bool SendRate::due(const Hoist::nanos_t now) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  if (writing_) {
+    stats_.skipped++;
+    return false;
+  }
+  // frames are offered about once every fastest, give or take
+  if (stats_.sent > 0 && now - started_ + fastest_ / 2 < stats_.interval) {
+    stats_.throttled++;
+    return false;
+  }
+  return true;
+}
+
+void SendRate::started(const Hoist::nanos_t now, const int64_t bytes) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  writing_ = true;
+  started_ = now;
+  stats_.sent++;
+  stats_.bytes += bytes;
+}
+
+void SendRate::finished(const Hoist::nanos_t now) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  if (!writing_) {
+    return;
+  }
+  writing_ = false;
+  Hoist::nanos_t latency = now - started_;
+  writes_.Put(latency);
+  if (latency > stats_.interval) {
+    stats_.interval = std::min(slowest_, stats_.interval * 2);
+  } else if (latency < stats_.interval / 2) {
+    stats_.interval = std::max(fastest_, stats_.interval - fastest_ / 4);
+  }
+}
+
+SendStats SendRate::stats() const {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void SendRate::toProto(const std::string& name,
+                       statusz::Stream* stream) const {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  stream->set_name(name);
+  stream->set_sent(stats_.sent);
+  stream->set_skipped(stats_.skipped);
+  stream->set_throttled(stats_.throttled);
+  stream->set_bytes(stats_.bytes);
+  stream->set_interval(stats_.interval);
+  summarize("write", writes_, stream->mutable_writes());
+}
+
+}  // namespace spacefight
@@ -0,0 +1,69 @@
+#ifndef NET_SPACEFIGHT_SEND_RATE_H
+#define NET_SPACEFIGHT_SEND_RATE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "hoist/clock.h"
+#include "proto/statusz/statusz.pb.h"
+#include "util/stats/histogram.h"
+
+namespace spacefight {
+
+// SendStats counts what happened to the frames offered to one client.
+struct SendStats {
+  // frames written
+  int64_t sent;
+  // frames dropped because the last one was still being written
+  int64_t skipped;
+  // frames dropped because the client was not due another yet
+  int64_t throttled;
+  int64_t bytes;
+  // current time between frames
+  Hoist::nanos_t interval;
+};
+
+// SendRate paces the frames sent to one client by how fast it takes them.
+//
+// A frame is only ever due once the last one finished writing, so frames
+// for a slow client are dropped instead of queued. Writes that take longer
+// than the interval between frames double the interval, up to slowest, and
+// writes that finish in under half of it shorten it again, down to fastest.
+//
+// Safe to use from any number of threads.
+class SendRate final {
+ public:
+  // number of recent write latencies kept
+  static constexpr uint64_t kWindow = 128;
+
+  SendRate(const Hoist::nanos_t fastest, const Hoist::nanos_t slowest);
+
+  SendRate(const SendRate&) = delete;
+  SendRate& operator=(const SendRate&) = delete;
+
+  // whether a frame should be written at now, counting it as dropped if not
+  bool due(const Hoist::nanos_t now);
+  // record that a frame started writing at now
+  void started(const Hoist::nanos_t now, const int64_t bytes);
+  // record that the frame being written finished at now
+  void finished(const Hoist::nanos_t now);
+
+  SendStats stats() const;
+
+  // write a summary of the frames sent so far
+  void toProto(const std::string& name, statusz::Stream* stream) const;
+
+ private:
+  const Hoist::nanos_t fastest_;
+  const Hoist::nanos_t slowest_;
+  mutable std::mutex mutex_;
+  SendStats stats_;
+  bool writing_;
+  // when the last frame started writing
+  Hoist::nanos_t started_;
+  util::stats::Histogram<Hoist::nanos_t> writes_;
+};
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,92 @@
+#include "net/spacefight/send_rate.h"
+
+#include "gtest/gtest.h"
+#include "proto/statusz/statusz.pb.h"
+
+namespace spacefight {
+namespace {
+
+static constexpr Hoist::nanos_t kFastest = 100;
+static constexpr Hoist::nanos_t kSlowest = 800;
+
+// offer a frame at now, and write it in latency if it is due
+bool offer(SendRate* rate, Hoist::nanos_t now, Hoist::nanos_t latency) {
+  if (!rate->due(now)) {
+    return false;
+  }
+  rate->started(now, 10);
+  rate->finished(now + latency);
+  return true;
+}
+
+TEST(SendRateTest, FastClientsGetEveryFrame) {
+  SendRate rate(kFastest, kSlowest);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(offer(&rate, i * kFastest, 1));
+  }
+  SendStats stats = rate.stats();
+  EXPECT_EQ(100, stats.sent);
+  EXPECT_EQ(0, stats.skipped);
+  EXPECT_EQ(0, stats.throttled);
+  EXPECT_EQ(1000, stats.bytes);
+  EXPECT_EQ(kFastest, stats.interval);
+}
+
+TEST(SendRateTest, FramesAreSkippedWhileWriting) {
+  SendRate rate(kFastest, kSlowest);
+  ASSERT_TRUE(rate.due(0));
+  rate.started(0, 10);
+  EXPECT_FALSE(rate.due(kFastest));
+  EXPECT_FALSE(rate.due(2 * kFastest));
+  rate.finished(2 * kFastest + 1);
+  EXPECT_EQ(2, rate.stats().skipped);
+}
+
+TEST(SendRateTest, SlowClientsBackOffToTheFloor) {
+  SendRate rate(kFastest, kSlowest);
+  Hoist::nanos_t now = 0;
+  for (int i = 0; i < 100; i++, now += kFastest) {
+    offer(&rate, now, 10 * kFastest);
+  }
+  SendStats stats = rate.stats();
+  EXPECT_EQ(kSlowest, stats.interval);
+  EXPECT_GT(stats.throttled, 0);
+  // only every slowest interval is a frame due
+  EXPECT_FALSE(rate.due(now));
+  now += kSlowest;
+  EXPECT_TRUE(rate.due(now));
+}
+
+TEST(SendRateTest, RecoversOnceWritesAreFast) {
+  SendRate rate(kFastest, kSlowest);
+  Hoist::nanos_t now = 0;
+  for (int i = 0; i < 100; i++, now += kFastest) {
+    offer(&rate, now, 10 * kFastest);
+  }
+  ASSERT_EQ(kSlowest, rate.stats().interval);
+  for (int i = 0; i < 200; i++, now += kFastest) {
+    offer(&rate, now, 1);
+  }
+  EXPECT_EQ(kFastest, rate.stats().interval);
+}
+
+TEST(SendRateTest, ToProto) {
+  SendRate rate(kFastest, kSlowest);
+  offer(&rate, 0, 7);
+  statusz::Stream stream;
+  rate.toProto("player 1", &stream);
+  EXPECT_EQ("player 1", stream.name());
+  EXPECT_EQ(1, stream.sent());
+  EXPECT_EQ(10, stream.bytes());
+  EXPECT_EQ(kFastest, stream.interval());
+  EXPECT_EQ(1, stream.writes().samples());
+  EXPECT_EQ(7, stream.writes().max());
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,14 +1,49 @@
+// Run a spacefight server.
+// usage:
+//  ./server            serve every call on its own thread
+//  ./server async [n]  serve every call on n completion queue threads
+// either may be preceded by options:
+//  --record path     record the game for ./replay
+//  --tick-threads n  split each game step across n threads
+//  --slowest-send-ms n
+//                    send slow clients a frame at least every n milliseconds
+//  --rooms n         host up to n games, each on its own pinned cpu
 #include <grpc++/grpc++.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
 #include "hoist/init.h"
 #include "hoist/logging.h"
-#include "net/spacefight/game.h"
+#include "net/spacefight/async_service.h"
+#include "net/spacefight/recording.h"
+#include "net/spacefight/rooms.h"
 #include "net/spacefight/service.h"
+#include "net/spacefight/stream.h"
 #include "net/statusz/service.h"
 
-void createAndRunSpacefight(spacefight::Game &game) {
+static constexpr int kDefaultAsyncThreads = 4;
+
+// report how the game loops are keeping up through statusz
+void addGameStatus(const spacefight::RoomManager &rooms,
+                   statusz::StatuszService *statusz) {
+  statusz->addProvider(
+      [&rooms](statusz::Status *status) { rooms.toProto(status); });
+}
+
+// report how fast each client is being sent frames through statusz
+void addClientStatus(const spacefight::ClientStreams &clients,
+                     statusz::StatuszService *statusz) {
+  statusz->addProvider(
+      [&clients](statusz::Status *status) { clients.toProto(status); });
+}
+
+void createAndRunSpacefight(spacefight::RoomManager &rooms,
+                            Hoist::nanos_t slowest_send) {
   std::string server_address("0.0.0.0:50099");
-  spacefight::SpacefightService service(game);
+  spacefight::SpacefightService service(rooms, slowest_send);
   statusz::StatuszService statusz;
+  addGameStatus(rooms, &statusz);
+  addClientStatus(service.clients(), &statusz);
 
   ILOG("Initializing server at " << server_address);
 
@@ -27,22 +62,95 @@ void createAndRunSpacefight(spacefight::Game &game) {
   server->Wait();
 }
 
-int main() {
+void createAndRunAsyncSpacefight(spacefight::RoomManager &rooms, int threads,
+                                 Hoist::nanos_t slowest_send) {
+  std::string server_address("0.0.0.0:50099");
+  spacefight::AsyncSpacefightService service(rooms, threads, slowest_send);
+  statusz::StatuszService statusz;
+  addGameStatus(rooms, &statusz);
+  addClientStatus(service.clients(), &statusz);
+
+  ILOG("Initializing async server at " << server_address);
+
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+  service.registerWith(&builder);
+  builder.RegisterService(&statusz);
+  builder.SetDefaultCompressionLevel(GRPC_COMPRESS_LEVEL_HIGH);
+
+  std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+  service.start();
+
+  ILOG("Server listening on " << server_address);
+  ILOG(" - spacefight enabled, " << threads << " threads");
+  ILOG(" - statusz enabled");
+
+  server->Wait();
+  service.shutdown();
+}
+
+int main(int argc, char *argv[]) {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
   Hoist::Init();
 
-  spacefight::Game game;
+  std::string program(argv[0]);
+  const char *record_path = nullptr;
+  spacefight::RoomOptions options;
+  Hoist::nanos_t slowest_send = spacefight::ClientStream::kSlowest;
+  while (argc >= 3 && std::string(argv[1]).rfind("--", 0) == 0) {
+    std::string option(argv[1]);
+    if (option == "--record") {
+      record_path = argv[2];
+    } else if (option == "--tick-threads") {
+      options.tick_threads = std::atoi(argv[2]);
+    } else if (option == "--slowest-send-ms") {
+      slowest_send = std::atoll(argv[2]) * 1000000;
+    } else if (option == "--rooms") {
+      options.max_rooms = std::atoi(argv[2]);
+      options.pin = true;
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+  bool async = argc >= 2 && std::string(argv[1]) == "async";
+  int threads = argc >= 3 ? std::atoi(argv[2]) : kDefaultAsyncThreads;
+  if ((argc >= 2 && !async) || argc > 3 || threads < 1 ||
+      options.tick_threads < 1 || slowest_send <= 0 || options.max_rooms < 1) {
+    std::cout << "Usage: \n"
+              << program
+              << " [--record path] [--tick-threads n] [--slowest-send-ms n]"
+              << " [--rooms n] [async [threads]]" << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<spacefight::Recorder> recorder;
+  if (record_path != nullptr) {
+    auto opened = spacefight::Recorder::open(record_path);
+    if (!opened.ok()) {
+      ELOG("cannot record to " << record_path << ": " << opened.status());
+      return 1;
+    }
+    recorder.reset(opened.ValueOrDie());
+    ILOG("Recording the default room to " << record_path);
+  }
 
   DLOG("Initializing game...");
-  game.start();
-  DLOG("Game initialized.");
+  {
+    spacefight::RoomManager rooms(options, std::move(recorder));
+    DLOG("Game initialized.");
 
-  createAndRunSpacefight(game);
+    if (async) {
+      createAndRunAsyncSpacefight(rooms, threads, slowest_send);
+    } else {
+      createAndRunSpacefight(rooms, slowest_send);
+    }
 
-  DLOG("Ending game...");
-  game.end();
+    DLOG("Ending game...");
+  }
   DLOG("Game over.");
 
   google::protobuf::ShutdownProtobufLibrary();
   return 0;
-}
\ No newline at end of file
+}
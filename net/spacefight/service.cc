@@ -1,57 +1,64 @@
 #include "net/spacefight/service.h"
 
 #include <unistd.h>
+#include <atomic>
 #include <chrono>
-#include <string>
 #include <thread>
 #include "hoist/logging.h"
-#include "hoist/math.h"
+#include "hoist/statusor.h"
 #include "net/spacefight/elements.h"
+#include "net/spacefight/update_context.h"
 
 namespace spacefight {
 
 grpc::Status SpacefightService::Login(grpc::ServerContext* context,
                                       const Registration* request,
                                       Token* response) {
-  DLOG("register " << request->username());
-
-  char token[65];
-  for (int i = 0; i < 64; i++) {
-    token[i] = Hoist::RNG::rand<char>('a', 'z' + 1);
+  if (!rooms_.login(*request, response)) {
+    return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                        "no room for another game");
   }
-  token[64] = '\0';
-  std::string tokens(token);
-  DLOG("create token " << tokens);
-
-  PlayerInput input;
-  input.set_token(tokens);
-  input.set_username(request->username());
-  int64_t player_id = game_.createNewPlayer(&input);
-
-  response->set_token(tokens);
-  response->set_player_id(player_id);
-
   return grpc::Status::OK;
 };
 
 grpc::Status SpacefightService::Update(
     grpc::ServerContext* context,
-    grpc::ServerReaderWriter<World, PlayerInput>* stream) {
-  // ok is true while either the read/write connection succeeds
-  bool ok = true;
+    grpc::ServerReaderWriter<Frame, PlayerInput>* stream) {
+  configureUpdateContext(context);
+
+  // the first input says which room the stream plays in
+  PlayerInput first;
+  if (context->IsCancelled() || !stream->Read(&first)) {
+    DLOG("read ended");
+    return grpc::Status::OK;
+  }
+  Hoist::StatusOr<std::shared_ptr<Room>> found = rooms_.find(first.token());
+  if (!found.ok()) {
+    DLOG("unknown player");
+    return grpc::Status(grpc::StatusCode::NOT_FOUND,
+                        found.status().error_message());
+  }
+  // held until the stream ends, even if the room closes first
+  std::shared_ptr<Room> room = found.ValueOrDie();
+  Game& game = room->game;
+  ClientStream client(game, room->sessions, slowest_send_);
+  clients_.add(&client);
 
-  PlayerInput input;
+  // ok is true while either the read/write connection succeeds, and is
+  // shared with the input thread
+  std::atomic<bool> ok(client.onInput(first));
+  Hoist::SystemClock clock;
 
   // receive input updates
-  std::thread input_thread([this, &context, &stream, &ok, &input]() {
+  std::thread input_thread([&context, &stream, &ok, &client]() {
+    PlayerInput input;
     while (ok) {
       if (context->IsCancelled() || !stream->Read(&input)) {
         ok = false;
         DLOG("read ended");
         return;
       }
-      game_.apply(&input);
-      if (input.quit()) {
+      if (!client.onInput(input)) {
         ok = false;
         DLOG("client quit");
         return;
@@ -59,26 +66,42 @@ grpc::Status SpacefightService::Update(
     }
   });
 
-  // stream world status updates
-  World world;
+  // stream every snapshot as soon as it is published, as often as the
+  // client keeps up with
+  static constexpr Hoist::nanos_t wait =
+      std::chrono::nanoseconds(settings::snapshot_wait).count();
+  int64_t tick = -1;
   while (ok) {
-    game_.getWorld(&world);
-    if (context->IsCancelled() || !stream->Write(world)) {
+    std::shared_ptr<const Snapshot> snapshot =
+        game.waitForSnapshot(tick, wait);
+    if (context->IsCancelled() || !snapshot) {
       ok = false;
       DLOG("write ended");
       break;
     }
-    std::this_thread::sleep_for(settings::world_update_interval);
+    if (snapshot->tick <= tick) {
+      continue;
+    }
+    tick = snapshot->tick;
+    if (client.sendRate().due(clock.nanos())) {
+      std::shared_ptr<const Frame> frame = client.next(snapshot);
+      client.sendRate().started(clock.nanos(), frame->ByteSizeLong());
+      bool written = stream->Write(*frame);
+      client.sendRate().finished(clock.nanos());
+      if (!written) {
+        ok = false;
+        DLOG("write ended");
+        break;
+      }
+    }
   }
 
   input_thread.join();
-
-  input.set_quit(true);
-  if (!input.token().empty()) {
-    game_.apply(&input);
-  }
+  clients_.remove(&client);
+  client.close();
+  rooms_.leave(first.token());
 
   return grpc::Status::OK;
 }
 
-}  // namespace spacefight
\ No newline at end of file
+}  // namespace spacefight
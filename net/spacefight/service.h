@@ -1,26 +1,41 @@
 #ifndef NET_SPACEFIGHT_SERVICE_H
 #define NET_SPACEFIGHT_SERVICE_H
 
-#include "net/spacefight/game.h"
+#include "hoist/clock.h"
+#include "net/spacefight/rooms.h"
+#include "net/spacefight/stream.h"
 #include "proto/spacefight/spacefight.pb.h"
 #include "proto/spacefight/spacefight_service.grpc.pb.h"
 
 namespace spacefight {
 
+// SpacefightService serves every call on its own gRPC thread, and reads each
+// Update stream on another thread of its own. Each stream plays in the room
+// its player logged into.
+//
+// Clients that are slow to take their frames are sent fewer of them, but
+// at least one every slowest_send nanoseconds.
 class SpacefightService final : public Spacefight::Service {
  public:
-  SpacefightService(Game& game) : game_(game) {}
+  SpacefightService(RoomManager& rooms,
+                    const Hoist::nanos_t slowest_send = ClientStream::kSlowest)
+      : rooms_(rooms), slowest_send_(slowest_send) {}
 
   ::grpc::Status Login(::grpc::ServerContext* context,
                        const Registration* request, Token* response) override;
   ::grpc::Status Update(
       ::grpc::ServerContext* context,
-      ::grpc::ServerReaderWriter<World, PlayerInput>* stream) override;
+      ::grpc::ServerReaderWriter<Frame, PlayerInput>* stream) override;
+
+  // the open Update streams
+  const ClientStreams& clients() const { return clients_; }
 
  private:
-  Game& game_;
+  RoomManager& rooms_;
+  const Hoist::nanos_t slowest_send_;
+  ClientStreams clients_;
 };
 
 }  // namespace spacefight
 
-#endif
\ No newline at end of file
+#endif
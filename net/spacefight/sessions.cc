@@ -0,0 +1,57 @@
+#include "net/spacefight/sessions.h"
+
+#include "hoist/logging.h"
+#include "hoist/math.h"
+#include "net/spacefight/token_map.h"
+
+namespace spacefight {
+
+void Sessions::login(const Registration& request, Token* response) {
+  DLOG("register " << request.username());
+
+  std::string token(kMaxTokenSize, ' ');
+  {
+    // the random number generator is not thread safe
+    std::scoped_lock<std::mutex> lock(mutex_);
+    for (char& c : token) {
+      c = Hoist::RNG::rand<char>('a', 'z' + 1);
+    }
+  }
+  DLOG("create token " << token);
+
+  PlayerInput input;
+  input.set_token(token);
+  input.set_username(request.username());
+  // the player enters the world at the start of a coming step, so logging
+  // in never waits for the game
+  int64_t player_id = game_.join(&input);
+
+  // compact frames are never deltas
+  bool particle_events = request.particle_events() && !request.compact();
+  {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    sessions_[token] = Session{player_id, request.compact(), particle_events};
+  }
+
+  response->set_token(token);
+  response->set_player_id(player_id);
+  response->set_compact(request.compact());
+  response->set_particle_events(particle_events);
+}
+
+bool Sessions::find(const std::string& token, Session* session) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  auto search = sessions_.find(token);
+  if (search == sessions_.end()) {
+    return false;
+  }
+  *session = search->second;
+  return true;
+}
+
+void Sessions::end(const std::string& token) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  sessions_.erase(token);
+}
+
+}  // namespace spacefight
@@ -0,0 +1,48 @@
+#ifndef NET_SPACEFIGHT_SESSIONS_H
+#define NET_SPACEFIGHT_SESSIONS_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "net/spacefight/game.h"
+#include "proto/spacefight/spacefight_service.pb.h"
+
+namespace spacefight {
+
+// Session is what Login agreed with a player.
+struct Session {
+  int64_t player_id;
+  // send CompactWorld frames
+  bool compact;
+  // send bullets and explosions as events in WorldDelta frames
+  bool particle_events;
+};
+
+// Sessions logs players into a game and remembers their sessions by token.
+// Safe to use from any number of threads.
+class Sessions final {
+ public:
+  explicit Sessions(Game& game) : game_(game) {}
+
+  Sessions(const Sessions&) = delete;
+  Sessions& operator=(const Sessions&) = delete;
+
+  // queue a player to join the game and create a session for them
+  void login(const Registration& request, Token* response);
+
+  // look up the session for a token, returning false if there is none
+  bool find(const std::string& token, Session* session);
+
+  // forget the session for a token
+  void end(const std::string& token);
+
+ private:
+  Game& game_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, Session> sessions_;
+};
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,240 @@
+#include "net/spacefight/snapshot.h"
+
+#include <zlib.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "hoist/logging.h"
+#include "net/spacefight/compact.h"
+#include "net/spacefight/delta.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/grid.h"
+#include "net/spacefight/physics.h"
+
+namespace spacefight {
+
+// InterestIndex locates the entities of a world.
+// Players are indexed by their position in the world, bullets follow the
+// players and explosions follow the bullets.
+struct InterestIndex {
+  InterestIndex() : grid(interest::cell_size) {}
+
+  SpatialGrid grid;
+  // player id to index into world.players()
+  std::unordered_map<int64_t, int> players;
+};
+
+namespace {
+
+using google::protobuf::Arena;
+using google::protobuf::ArenaOptions;
+
+ArenaOptions arenaOptions(const size_t bytes) {
+  ArenaOptions options;
+  if (bytes > options.start_block_size) {
+    options.start_block_size = bytes;
+    options.max_block_size = std::max(options.max_block_size, bytes);
+  }
+  return options;
+}
+
+phys::AABB bounds(const game::Body& body) {
+  phys::AABB box;
+  box.x1 = body.phys().pos().x();
+  box.y1 = body.phys().pos().y();
+  box.x2 = box.x1 + body.size().x();
+  box.y2 = box.y1 + body.size().y();
+  return box;
+}
+
+int32_t interestCell(const float f) {
+  return static_cast<int32_t>(std::floor(f / interest::cell_size));
+}
+
+uint64_t areaKey(const int32_t cx, const int32_t cy) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+         static_cast<uint32_t>(cy);
+}
+
+// the box every ship in an interest cell can see
+phys::AABB areaBounds(const int32_t cx, const int32_t cy) {
+  static constexpr float reach = interest::radius + interest::margin;
+  phys::AABB box;
+  box.x1 = cx * interest::cell_size - reach;
+  box.y1 = cy * interest::cell_size - reach;
+  box.x2 = (cx + 1) * interest::cell_size + reach;
+  box.y2 = (cy + 1) * interest::cell_size + reach;
+  return box;
+}
+
+void buildIndex(const World& world, InterestIndex* index) {
+  int id = 0;
+  for (const Player& player : world.players()) {
+    index->players[player.id()] = id;
+    index->grid.insert(id++, bounds(player.ship().body()));
+  }
+  for (const Bullet& bullet : world.bullets()) {
+    index->grid.insert(id++, bounds(bullet.body()));
+  }
+  for (const Explosion& explosion : world.explosions()) {
+    index->grid.insert(id++, bounds(explosion.body()));
+  }
+  index->grid.build();
+}
+
+bool deflateString(const std::string& in, std::string* out) {
+  uLongf size = compressBound(in.size());
+  out->resize(size);
+  int rc = compress2(reinterpret_cast<Bytef*>(&(*out)[0]), &size,
+                     reinterpret_cast<const Bytef*>(in.data()), in.size(),
+                     Z_DEFAULT_COMPRESSION);
+  if (rc != Z_OK) {
+    ELOG("deflate failed: " << rc);
+    return false;
+  }
+  out->resize(size);
+  return true;
+}
+
+// serialize a message into bytes, returning the encoding used
+Frame::Encoding encodeMessage(const google::protobuf::MessageLite& message,
+                              const bool compress, std::string* bytes) {
+  if (compress) {
+    std::string raw;
+    message.SerializeToString(&raw);
+    if (deflateString(raw, bytes)) {
+      return Frame::DEFLATE;
+    }
+    // fall back to sending the message uncompressed
+    bytes->swap(raw);
+  } else {
+    message.SerializeToString(bytes);
+  }
+  return Frame::RAW;
+}
+
+}  // namespace
+
+Snapshot::Snapshot(const size_t arena_bytes)
+    : tick(0),
+      area(kWholeWorld),
+      compress(false),
+      arena(arenaOptions(arena_bytes)),
+      world(*Arena::CreateMessage<World>(&arena)),
+      frame(*Arena::CreateMessage<Frame>(&arena)) {}
+
+Snapshot::~Snapshot() {}
+
+std::shared_ptr<const Frame> Snapshot::deltaFrom(
+    const Snapshot& baseline, const bool particle_events) const {
+  std::scoped_lock<std::mutex> lock(cache_mutex);
+  std::shared_ptr<const Frame>& cached =
+      deltas[std::make_tuple(baseline.tick, baseline.area, particle_events)];
+  if (!cached) {
+    // only needed until it is encoded
+    Arena scratch;
+    WorldDelta* delta = Arena::CreateMessage<WorldDelta>(&scratch);
+    delta->set_baseline_tick(baseline.tick);
+    if (particle_events) {
+      diffWorldEvents(baseline.world, world,
+                      (tick - baseline.tick) * settings::step_seconds, delta);
+    } else {
+      diffWorlds(baseline.world, world, delta);
+    }
+    std::shared_ptr<Frame> frame = std::make_shared<Frame>();
+    encodeFrame(tick, *delta, compress, frame.get());
+    cached = std::move(frame);
+  }
+  return cached;
+}
+
+std::shared_ptr<const Frame> Snapshot::compactSince(
+    const bool all_metadata) const {
+  std::scoped_lock<std::mutex> lock(cache_mutex);
+  std::shared_ptr<const Frame>& cached = compacts[all_metadata];
+  if (!cached) {
+    // only needed until it is encoded
+    Arena scratch;
+    CompactWorld* compacted = Arena::CreateMessage<CompactWorld>(&scratch);
+    compactWorld(world, all_metadata, compacted);
+    std::shared_ptr<Frame> frame = std::make_shared<Frame>();
+    encodeFrame(tick, *compacted, compress, frame.get());
+    cached = std::move(frame);
+  }
+  return cached;
+}
+
+std::shared_ptr<const Snapshot> Snapshot::viewAround(
+    const int64_t player_id) const {
+  std::scoped_lock<std::mutex> lock(cache_mutex);
+  if (!index) {
+    index.reset(new InterestIndex());
+    buildIndex(world, index.get());
+  }
+  auto search = index->players.find(player_id);
+  if (search == index->players.end()) {
+    return nullptr;
+  }
+  const game::Vector& pos =
+      world.players(search->second).ship().body().phys().pos();
+  int32_t cx = interestCell(pos.x());
+  int32_t cy = interestCell(pos.y());
+  std::shared_ptr<const Snapshot>& cached = views[areaKey(cx, cy)];
+  if (cached) {
+    return cached;
+  }
+
+  std::shared_ptr<Snapshot> view = std::make_shared<Snapshot>();
+  view->tick = tick;
+  view->area = areaKey(cx, cy);
+  view->compress = compress;
+  phys::AABB box = areaBounds(cx, cy);
+  std::vector<int> candidates;
+  index->grid.query(box, &candidates);
+  // candidates are ascending, so every kind keeps its order in the world
+  const int players = world.players_size();
+  const int bullets = world.bullets_size();
+  for (int id : candidates) {
+    if (id < players) {
+      const Player& player = world.players(id);
+      if (phys::intersects(box, bounds(player.ship().body()))) {
+        view->world.add_players()->CopyFrom(player);
+      }
+    } else if (id < players + bullets) {
+      const Bullet& bullet = world.bullets(id - players);
+      if (phys::intersects(box, bounds(bullet.body()))) {
+        view->world.add_bullets()->CopyFrom(bullet);
+      }
+    } else {
+      const Explosion& explosion = world.explosions(id - players - bullets);
+      if (phys::intersects(box, bounds(explosion.body()))) {
+        view->world.add_explosions()->CopyFrom(explosion);
+      }
+    }
+  }
+  encodeFrame(tick, view->world, compress, &view->frame);
+  cached = std::move(view);
+  return cached;
+}
+
+void encodeFrame(const int64_t tick, const World& world, const bool compress,
+                 Frame* frame) {
+  frame->set_tick(tick);
+  frame->set_encoding(encodeMessage(world, compress, frame->mutable_world()));
+}
+
+void encodeFrame(const int64_t tick, const CompactWorld& compacted,
+                 const bool compress, Frame* frame) {
+  frame->set_tick(tick);
+  frame->set_encoding(
+      encodeMessage(compacted, compress, frame->mutable_compact_world()));
+}
+
+void encodeFrame(const int64_t tick, const WorldDelta& delta,
+                 const bool compress, Frame* frame) {
+  frame->set_tick(tick);
+  frame->set_encoding(encodeMessage(delta, compress, frame->mutable_delta()));
+}
+
+}  // namespace spacefight
@@ -0,0 +1,91 @@
+#ifndef NET_SPACEFIGHT_SNAPSHOT_H
+#define NET_SPACEFIGHT_SNAPSHOT_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <google/protobuf/arena.h>
+#include "proto/spacefight/spacefight.pb.h"
+
+namespace spacefight {
+
+struct InterestIndex;
+
+// Snapshot is the world as of one update.
+// Snapshots are immutable once published and are shared by every stream.
+//
+// The world and its frame live on an arena owned by the snapshot, so building
+// a snapshot takes a handful of allocations and freeing it releases them all
+// at once instead of message by message.
+struct Snapshot {
+  // area of a snapshot that holds the whole world
+  static constexpr uint64_t kWholeWorld = UINT64_MAX;
+
+  // arena_bytes sizes the first block of the arena, pass what a similar
+  // snapshot used to build the whole world in a single block.
+  explicit Snapshot(const size_t arena_bytes = 0);
+  ~Snapshot();
+
+  // number of the update that produced this snapshot
+  int64_t tick;
+  // the interest cell this snapshot was cut down to, or kWholeWorld
+  uint64_t area;
+  // whether frames built from this snapshot are compressed
+  bool compress;
+  // owns world and frame
+  google::protobuf::Arena arena;
+  // the world, for readers that need to inspect it
+  World& world;
+  // the world encoded once, ready to be written to any number of streams
+  Frame& frame;
+
+  // get a frame with the changes since an older snapshot, optionally with
+  // bullets and explosions sent as events.
+  // each delta is encoded once, no matter how many streams share a baseline.
+  std::shared_ptr<const Frame> deltaFrom(
+      const Snapshot& baseline, const bool particle_events = false) const;
+
+  // get a CompactWorld frame, with the metadata of every player for streams
+  // that have not been sent all of it, otherwise with none.
+  // each of the two is encoded once, no matter how many streams share it.
+  std::shared_ptr<const Frame> compactSince(const bool all_metadata) const;
+
+  // get the part of the world around a player's ship, as its own snapshot.
+  // players whose ships share an interest cell share one view.
+  // returns null if the player has no ship in this snapshot.
+  std::shared_ptr<const Snapshot> viewAround(const int64_t player_id) const;
+
+  mutable std::mutex cache_mutex;
+  // deltas already encoded, by baseline tick, area and whether they send
+  // particle events
+  mutable std::map<std::tuple<int64_t, uint64_t, bool>,
+                   std::shared_ptr<const Frame>>
+      deltas;
+  // compact worlds already encoded, without and with player metadata
+  mutable std::shared_ptr<const Frame> compacts[2];
+  // spatial index of the world, built for the first view
+  mutable std::unique_ptr<InterestIndex> index;
+  // views already cut, by area
+  mutable std::unordered_map<uint64_t, std::shared_ptr<const Snapshot>> views;
+};
+
+// encode a world into a keyframe, optionally compressing it
+void encodeFrame(const int64_t tick, const World& world, const bool compress,
+                 Frame* frame);
+
+// encode a compact world into a frame, optionally compressing it
+void encodeFrame(const int64_t tick, const CompactWorld& compacted,
+                 const bool compress, Frame* frame);
+
+// encode a delta into a frame, optionally compressing it
+void encodeFrame(const int64_t tick, const WorldDelta& delta,
+                 const bool compress, Frame* frame);
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,168 @@
+#include "net/spacefight/snapshot.h"
+
+#include <zlib.h>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "net/spacefight/delta.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/physics.h"
+
+namespace spacefight {
+namespace {
+
+World makeWorld() {
+  World world;
+  for (int i = 0; i < 50; i++) {
+    Player* player = world.add_players();
+    player->set_id(i);
+    player->set_username("player");
+    game::Body* body = player->mutable_ship()->mutable_body();
+    body->mutable_phys()->mutable_pos()->set_x(i);
+  }
+  return world;
+}
+
+TEST(SnapshotTest, EncodeRaw) {
+  World world = makeWorld();
+  Frame frame;
+  encodeFrame(7, world, false, &frame);
+
+  EXPECT_EQ(7, frame.tick());
+  EXPECT_EQ(Frame::RAW, frame.encoding());
+  World decoded;
+  ASSERT_TRUE(decoded.ParseFromString(frame.world()));
+  EXPECT_EQ(world.SerializeAsString(), decoded.SerializeAsString());
+}
+
+TEST(SnapshotTest, EncodeDeflate) {
+  World world = makeWorld();
+  Frame frame;
+  encodeFrame(8, world, true, &frame);
+
+  EXPECT_EQ(8, frame.tick());
+  EXPECT_EQ(Frame::DEFLATE, frame.encoding());
+  std::string raw = world.SerializeAsString();
+  EXPECT_LT(frame.world().size(), raw.size());
+
+  std::string inflated(raw.size(), '\0');
+  uLongf size = inflated.size();
+  ASSERT_EQ(Z_OK, uncompress(reinterpret_cast<Bytef*>(&inflated[0]), &size,
+                             reinterpret_cast<const Bytef*>(
+                                 frame.world().data()),
+                             frame.world().size()));
+  inflated.resize(size);
+  EXPECT_EQ(raw, inflated);
+}
+
+void addPlayer(World* world, int64_t id, float x, float y) {
+  Player* player = world->add_players();
+  player->set_id(id);
+  game::Body* body = player->mutable_ship()->mutable_body();
+  phys::set(body->mutable_phys(), x, y);
+  phys::set(body->mutable_size(), ships::size, ships::size);
+}
+
+void addBullet(World* world, int64_t id, float x, float y) {
+  Bullet* bullet = world->add_bullets();
+  bullet->set_id(id);
+  game::Body* body = bullet->mutable_body();
+  phys::set(body->mutable_phys(), x, y);
+  phys::set(body->mutable_size(), bullets::size, bullets::size);
+}
+
+std::shared_ptr<Snapshot> makeSnapshot(int64_t tick) {
+  std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+  snapshot->tick = tick;
+  snapshot->compress = false;
+  return snapshot;
+}
+
+std::vector<int64_t> playerIds(const World& world) {
+  std::vector<int64_t> ids;
+  for (const Player& player : world.players()) {
+    ids.push_back(player.id());
+  }
+  return ids;
+}
+
+TEST(SnapshotTest, ViewAroundKeepsNearbyEntities) {
+  static constexpr float far = 3 * (interest::radius + interest::margin);
+  std::shared_ptr<Snapshot> snapshot = makeSnapshot(1);
+  addPlayer(&snapshot->world, 1, 10, 10);
+  addPlayer(&snapshot->world, 2, far, 0);
+  addPlayer(&snapshot->world, 3, -interest::radius, interest::radius);
+  addBullet(&snapshot->world, 4, 100, 100);
+  addBullet(&snapshot->world, 5, 0, -far);
+
+  std::shared_ptr<const Snapshot> view = snapshot->viewAround(1);
+
+  ASSERT_TRUE(view);
+  EXPECT_EQ(1, view->tick);
+  EXPECT_NE(Snapshot::kWholeWorld, view->area);
+  EXPECT_EQ(std::vector<int64_t>({1, 3}), playerIds(view->world));
+  ASSERT_EQ(1, view->world.bullets_size());
+  EXPECT_EQ(4, view->world.bullets(0).id());
+  World decoded;
+  ASSERT_TRUE(decoded.ParseFromString(view->frame.world()));
+  EXPECT_EQ(view->world.SerializeAsString(), decoded.SerializeAsString());
+}
+
+TEST(SnapshotTest, ViewsAreSharedWithinACell) {
+  std::shared_ptr<Snapshot> snapshot = makeSnapshot(1);
+  addPlayer(&snapshot->world, 1, 10, 10);
+  addPlayer(&snapshot->world, 2, 20, 20);
+  addPlayer(&snapshot->world, 3, 10 + interest::cell_size, 10);
+
+  EXPECT_EQ(snapshot->viewAround(1), snapshot->viewAround(2));
+  EXPECT_NE(snapshot->viewAround(1), snapshot->viewAround(3));
+  EXPECT_FALSE(snapshot->viewAround(4));
+}
+
+TEST(SnapshotTest, DeltaBetweenViews) {
+  static constexpr float far = 3 * (interest::radius + interest::margin);
+  std::shared_ptr<Snapshot> before = makeSnapshot(1);
+  addPlayer(&before->world, 1, 0, 0);
+  addPlayer(&before->world, 2, 200, 0);
+  addPlayer(&before->world, 3, far, 0);
+  std::shared_ptr<Snapshot> after = makeSnapshot(2);
+  // player 1 flies towards player 3 and out of sight of player 2
+  addPlayer(&after->world, 1, far - 200, 0);
+  addPlayer(&after->world, 2, 200, 0);
+  addPlayer(&after->world, 3, far, 0);
+
+  std::shared_ptr<const Snapshot> baseline = before->viewAround(1);
+  std::shared_ptr<const Snapshot> current = after->viewAround(1);
+  ASSERT_NE(baseline->area, current->area);
+  std::shared_ptr<const Frame> frame = current->deltaFrom(*baseline);
+
+  WorldDelta delta;
+  ASSERT_TRUE(delta.ParseFromString(frame->delta()));
+  World world(baseline->world);
+  applyDelta(delta, &world);
+  EXPECT_EQ(std::vector<int64_t>({1, 3}), playerIds(world));
+  // the same tick from another area is a different baseline
+  EXPECT_NE(frame, current->deltaFrom(*before));
+}
+
+TEST(SnapshotTest, ParticleEventDeltasAreSeparate) {
+  std::shared_ptr<Snapshot> before = makeSnapshot(1);
+  std::shared_ptr<Snapshot> after = makeSnapshot(3);
+
+  std::shared_ptr<const Frame> frame = after->deltaFrom(*before, true);
+  EXPECT_EQ(frame, after->deltaFrom(*before, true));
+  EXPECT_NE(frame, after->deltaFrom(*before));
+
+  WorldDelta delta;
+  ASSERT_TRUE(delta.ParseFromString(frame->delta()));
+  EXPECT_TRUE(delta.particle_events());
+  EXPECT_FLOAT_EQ(2 * settings::step_seconds, delta.elapsed());
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+#include "net/spacefight/stream.h"
+
+#include <algorithm>
+#include <string>
+#include "hoist/logging.h"
+#include "net/spacefight/elements.h"
+
+namespace spacefight {
+
+namespace {
+
+// whether two inputs hold down the same controls
+bool sameControls(const PlayerInput& a, const PlayerInput& b) {
+  return a.rotate_left() == b.rotate_left() &&
+         a.rotate_right() == b.rotate_right() && a.thrust() == b.thrust() &&
+         a.fire() == b.fire();
+}
+
+}  // namespace
+
+bool ClientStream::onInput(const PlayerInput& input) {
+  input_.CopyFrom(input);
+  if (!identified_) {
+    Session session;
+    if (sessions_.find(input.token(), &session)) {
+      compact_ = session.compact;
+      particle_events_ = session.particle_events;
+      player_id_ = session.player_id;
+    }
+    identified_ = true;
+  }
+  baselines_.ack(input.ack_tick());
+  // clients acknowledge every frame, only pass on real input changes
+  if (input.quit() || !sameControls(input, applied_)) {
+    game_.apply(&input);
+    applied_.CopyFrom(input);
+  }
+  return !input.quit();
+}
+
+std::shared_ptr<const Frame> ClientStream::next(
+    std::shared_ptr<const Snapshot> snapshot) {
+  if (settings::filter_interest && player_id_) {
+    std::shared_ptr<const Snapshot> view = snapshot->viewAround(player_id_);
+    if (view) {
+      snapshot = std::move(view);
+    }
+  }
+  if (!compact_) {
+    return baselines_.next(snapshot, particle_events_);
+  }
+  // players come into view long after joining, so metadata is sent for
+  // every visible player whenever one of them was not visible last time
+  visible_.clear();
+  for (const Player& player : snapshot->world.players()) {
+    visible_.push_back(player.id());
+  }
+  std::sort(visible_.begin(), visible_.end());
+  const bool unknown = !std::includes(known_.begin(), known_.end(),
+                                      visible_.begin(), visible_.end());
+  known_.swap(visible_);
+  return snapshot->compactSince(unknown);
+}
+
+void ClientStream::close() {
+  if (input_.token().empty()) {
+    return;
+  }
+  sessions_.end(input_.token());
+  if (!input_.quit()) {
+    input_.set_quit(true);
+    game_.apply(&input_);
+  }
+}
+
+void ClientStreams::add(ClientStream* client) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  clients_.insert(client);
+}
+
+void ClientStreams::remove(ClientStream* client) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  clients_.erase(client);
+}
+
+void ClientStreams::toProto(statusz::Status* status) const {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  for (const ClientStream* client : clients_) {
+    client->sendRate().toProto("player " + std::to_string(client->playerId()),
+                               status->add_streams());
+  }
+}
+
+}  // namespace spacefight
@@ -0,0 +1,109 @@
+#ifndef NET_SPACEFIGHT_STREAM_H
+#define NET_SPACEFIGHT_STREAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "hoist/clock.h"
+#include "net/spacefight/baseline.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/game.h"
+#include "net/spacefight/send_rate.h"
+#include "net/spacefight/sessions.h"
+#include "net/spacefight/snapshot.h"
+#include "proto/spacefight/spacefight.pb.h"
+#include "proto/statusz/statusz.pb.h"
+
+namespace spacefight {
+
+// ClientStream is one client's Update stream, apart from its transport:
+// which player it belongs to, the input it sends and the frames it is sent.
+//
+// onInput() and close() are called by whatever reads the stream, one at a
+// time. next() may be called from another thread that writes the stream,
+// which paces its writes with sendRate().
+class ClientStream final {
+ public:
+  // frames are offered once every world update at most
+  static constexpr Hoist::nanos_t kFastest =
+      std::chrono::nanoseconds(settings::world_update_interval).count();
+  static constexpr Hoist::nanos_t kSlowest =
+      std::chrono::nanoseconds(settings::slowest_send_interval).count();
+
+  // slowest is the longest the client may be made to wait between frames
+  ClientStream(Game& game, Sessions& sessions,
+               const Hoist::nanos_t slowest = kSlowest)
+      : game_(game),
+        sessions_(sessions),
+        player_id_(0),
+        compact_(false),
+        particle_events_(false),
+        identified_(false),
+        rate_(kFastest, slowest) {}
+
+  ClientStream(const ClientStream&) = delete;
+  ClientStream& operator=(const ClientStream&) = delete;
+
+  // handle an input read from the stream.
+  // returns false once the client has quit.
+  bool onInput(const PlayerInput& input);
+
+  // get the frame to send a client for a snapshot
+  std::shared_ptr<const Frame> next(std::shared_ptr<const Snapshot> snapshot);
+
+  // remove the player from the game, once the stream has ended
+  void close();
+
+  // get the player, or 0 until the client has identified itself
+  int64_t playerId() const { return player_id_; }
+
+  SendRate& sendRate() { return rate_; }
+  const SendRate& sendRate() const { return rate_; }
+
+ private:
+  Game& game_;
+  Sessions& sessions_;
+  // the player and format are known once the first input names the player
+  std::atomic<int64_t> player_id_;
+  std::atomic<bool> compact_;
+  std::atomic<bool> particle_events_;
+  bool identified_;
+  // the latest input, and the latest input that changed the controls
+  PlayerInput input_;
+  PlayerInput applied_;
+  BaselineTracker baselines_;
+  // sorted ids of the players visible in the last frame, and scratch space
+  // to collect the next frame's, both only used by next()
+  std::vector<int64_t> known_;
+  std::vector<int64_t> visible_;
+  SendRate rate_;
+};
+
+// ClientStreams keeps track of the open streams, to report on them.
+// Safe to use from any number of threads.
+class ClientStreams final {
+ public:
+  ClientStreams() {}
+
+  ClientStreams(const ClientStreams&) = delete;
+  ClientStreams& operator=(const ClientStreams&) = delete;
+
+  // add a stream, which must be removed before it is destroyed
+  void add(ClientStream* client);
+  void remove(ClientStream* client);
+
+  // write the send stats of every stream
+  void toProto(statusz::Status* status) const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_set<ClientStream*> clients_;
+};
+
+}  // namespace spacefight
+
+#endif
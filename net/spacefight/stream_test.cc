@@ -0,0 +1,170 @@
+#include "net/spacefight/stream.h"
+
+#include <zlib.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "hoist/clock.h"
+#include "net/spacefight/elements.h"
+#include "net/spacefight/game.h"
+#include "net/spacefight/sessions.h"
+
+namespace spacefight {
+namespace {
+
+// decode a compact frame, as a client would
+bool decode(const Frame& frame, CompactWorld* compacted) {
+  if (frame.encoding() == Frame::RAW) {
+    return compacted->ParseFromString(frame.compact_world());
+  }
+  std::string raw(1 << 16, '\0');
+  uLongf size = raw.size();
+  if (uncompress(reinterpret_cast<Bytef*>(&raw[0]), &size,
+                 reinterpret_cast<const Bytef*>(frame.compact_world().data()),
+                 frame.compact_world().size()) != Z_OK) {
+    return false;
+  }
+  raw.resize(size);
+  return compacted->ParseFromString(raw);
+}
+
+class ClientStreamTest : public ::testing::Test {
+ protected:
+  ClientStreamTest()
+      : clock_(std::make_shared<Hoist::ManualClock>()),
+        game_(clock_, 0),
+        sessions_(game_) {
+    game_.start();
+  }
+  ~ClientStreamTest() { game_.end(); }
+
+  Token login(bool compact, bool particle_events = false) {
+    Registration registration;
+    registration.set_username("pilot");
+    registration.set_compact(compact);
+    registration.set_particle_events(particle_events);
+    Token token;
+    sessions_.login(registration, &token);
+    return token;
+  }
+
+  PlayerInput input(const Token& token) {
+    PlayerInput input;
+    input.set_token(token.token());
+    return input;
+  }
+
+  // publish a snapshot with everything that happened so far
+  void update() {
+    clock_->advance(
+        std::chrono::nanoseconds(settings::game_update_interval).count());
+    game_.update();
+  }
+
+  std::shared_ptr<Hoist::ManualClock> clock_;
+  Game game_;
+  Sessions sessions_;
+};
+
+TEST_F(ClientStreamTest, LoginCreatesSession) {
+  Token token = login(true);
+
+  Session session;
+  ASSERT_TRUE(sessions_.find(token.token(), &session));
+  EXPECT_EQ(token.player_id(), session.player_id);
+  EXPECT_TRUE(session.compact);
+  EXPECT_TRUE(token.compact());
+  EXPECT_EQ(64u, token.token().size());
+}
+
+TEST_F(ClientStreamTest, ParticleEventsOnlyWithoutCompact) {
+  Token token = login(false, true);
+  Session session;
+  ASSERT_TRUE(sessions_.find(token.token(), &session));
+  EXPECT_TRUE(session.particle_events);
+  EXPECT_TRUE(token.particle_events());
+
+  token = login(true, true);
+  ASSERT_TRUE(sessions_.find(token.token(), &session));
+  EXPECT_FALSE(session.particle_events);
+  EXPECT_FALSE(token.particle_events());
+}
+
+TEST_F(ClientStreamTest, WholeWorldUntilIdentified) {
+  login(false);
+  ClientStream client(game_, sessions_);
+
+  std::shared_ptr<const Snapshot> snapshot = game_.getSnapshot();
+  std::shared_ptr<const Frame> frame = client.next(snapshot);
+
+  EXPECT_EQ(&snapshot->frame, frame.get());
+}
+
+TEST_F(ClientStreamTest, CompactOnceIdentified) {
+  Token token = login(true);
+  ClientStream client(game_, sessions_);
+  EXPECT_TRUE(client.onInput(input(token)));
+
+  update();
+  std::shared_ptr<const Frame> frame = client.next(game_.getSnapshot());
+
+  ASSERT_TRUE(frame->has_compact_world());
+  CompactWorld compacted;
+  ASSERT_TRUE(decode(*frame, &compacted));
+  ASSERT_EQ(1, compacted.players_size());
+  EXPECT_EQ(token.player_id(), compacted.players(0).id());
+
+  // metadata is only sent once
+  frame = client.next(game_.getSnapshot());
+  ASSERT_TRUE(decode(*frame, &compacted));
+  EXPECT_EQ(0, compacted.players_size());
+}
+
+TEST_F(ClientStreamTest, MetadataResentWhenBackInView) {
+  Token token = login(true);
+  ClientStream client(game_, sessions_);
+  EXPECT_TRUE(client.onInput(input(token)));
+
+  // the client's own ship is not in these worlds, so each is sent whole
+  auto world = [](std::vector<int64_t> ids) {
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    snapshot->compress = false;
+    for (int64_t id : ids) {
+      snapshot->world.add_players()->set_id(id);
+    }
+    return snapshot;
+  };
+  CompactWorld compacted;
+  ASSERT_TRUE(decode(*client.next(world({7, 8})), &compacted));
+  EXPECT_EQ(2, compacted.players_size());
+  ASSERT_TRUE(decode(*client.next(world({7})), &compacted));
+  EXPECT_EQ(0, compacted.players_size());
+
+  // 8 left the view and came back, so its metadata is sent again
+  ASSERT_TRUE(decode(*client.next(world({8, 7})), &compacted));
+  EXPECT_EQ(2, compacted.players_size());
+}
+
+TEST_F(ClientStreamTest, QuitEndsSession) {
+  Token token = login(false);
+  ClientStream client(game_, sessions_);
+  EXPECT_TRUE(client.onInput(input(token)));
+
+  PlayerInput quit = input(token);
+  quit.set_quit(true);
+  EXPECT_FALSE(client.onInput(quit));
+  client.close();
+
+  Session session;
+  EXPECT_FALSE(sessions_.find(token.token(), &session));
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,99 @@
+#include "net/spacefight/tick_stats.h"
+
+#include <vector>
+
+namespace spacefight {
+
+namespace {
+
+// names of each phase, as reported in statusz
+const char* const kPhaseNames[TickStats::kNumPhases] = {
+    "inputs",     "bullet_collisions", "ships",    "bullets",
+    "explosions", "ai",                "snapshot",
+};
+
+// running total of each phase
+Hoist::nanos_t PhaseTimes::*const kPhaseTotals[TickStats::kNumPhases] = {
+    &PhaseTimes::inputs,     &PhaseTimes::bullet_collisions,
+    &PhaseTimes::ships,      &PhaseTimes::bullets,
+    &PhaseTimes::explosions, &PhaseTimes::ai,
+    &PhaseTimes::snapshot,
+};
+
+}  // namespace
+
+void summarize(const char* name,
+               const util::stats::Histogram<Hoist::nanos_t>& histogram,
+               statusz::Latency* latency) {
+  latency->set_name(name);
+  latency->set_samples(histogram.Size());
+  std::vector<Hoist::nanos_t> percentiles;
+  histogram.Percentiles({0.5, 0.9, 0.99, 1}, percentiles);
+  if (percentiles.empty()) {
+    return;
+  }
+  latency->set_p50(percentiles[0]);
+  latency->set_p90(percentiles[1]);
+  latency->set_p99(percentiles[2]);
+  latency->set_max(percentiles[3]);
+}
+
+TickStats::TickStats(const Hoist::nanos_t interval)
+    : interval_(interval),
+      totals_{},
+      tick_(kWindow),
+      count_(0),
+      overruns_(0),
+      dropped_(0),
+      ships_(0),
+      bullets_(0),
+      explosions_(0) {
+  for (int i = 0; i < kNumPhases; i++) {
+    phases_[i].reset(new Histogram(kWindow));
+  }
+}
+
+void TickStats::put(const Phase phase, const Hoist::nanos_t nanos) {
+  totals_.*kPhaseTotals[phase] += nanos;
+  // a step starts with its inputs
+  if (phase == kInputs) {
+    totals_.steps++;
+  } else if (phase == kSnapshot) {
+    totals_.snapshots++;
+  }
+  phases_[phase]->Put(nanos);
+}
+
+void TickStats::putTick(const Hoist::nanos_t nanos, const int steps,
+                        const int64_t dropped) {
+  tick_.Put(nanos);
+  count_ += steps;
+  dropped_ += dropped;
+  if (nanos > interval_) {
+    overruns_++;
+  }
+}
+
+void TickStats::putEntities(const int64_t ships, const int64_t bullets,
+                            const int64_t explosions) {
+  ships_ = ships;
+  bullets_ = bullets;
+  explosions_ = explosions;
+}
+
+void TickStats::toProto(statusz::Ticks* ticks) const {
+  ticks->set_interval(interval_);
+  ticks->set_count(count_);
+  ticks->set_overruns(overruns_);
+  ticks->set_dropped(dropped_);
+  summarize("tick", tick_, ticks->add_latencies());
+  for (int i = 0; i < kNumPhases; i++) {
+    summarize(kPhaseNames[i], *phases_[i], ticks->add_latencies());
+  }
+  auto* entities = ticks->mutable_entities();
+  (*entities)["ships"] = ships_;
+  (*entities)["bullets"] = bullets_;
+  (*entities)["explosions"] = explosions_;
+}
+
+}  // namespace spacefight
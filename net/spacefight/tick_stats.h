@@ -0,0 +1,94 @@
+#ifndef NET_SPACEFIGHT_TICK_STATS_H
+#define NET_SPACEFIGHT_TICK_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "hoist/clock.h"
+#include "proto/statusz/statusz.pb.h"
+#include "util/stats/histogram.h"
+
+namespace spacefight {
+
+// PhaseTimes is the wall time spent in each phase of an update, summed over
+// every update since the game was created.
+struct PhaseTimes {
+  // number of steps and snapshots the sums cover
+  int64_t steps;
+  int64_t snapshots;
+  // per step
+  Hoist::nanos_t inputs;
+  Hoist::nanos_t bullet_collisions;
+  Hoist::nanos_t ships;
+  Hoist::nanos_t bullets;
+  Hoist::nanos_t explosions;
+  Hoist::nanos_t ai;
+  // per snapshot
+  Hoist::nanos_t snapshot;
+};
+
+// summarize the durations in a histogram
+void summarize(const char* name,
+               const util::stats::Histogram<Hoist::nanos_t>& histogram,
+               statusz::Latency* latency);
+
+// TickStats records how long the ticks of a game take.
+//
+// Every duration goes into a running total and into a histogram of the most
+// recent durations. Recording is only done by the thread updating the game,
+// but toProto() may be called from any thread at any time.
+class TickStats final {
+ public:
+  enum Phase {
+    kInputs,
+    kBulletCollisions,
+    kShips,
+    kBullets,
+    kExplosions,
+    kAI,
+    kSnapshot,
+    kNumPhases,
+  };
+
+  // number of recent durations kept for each histogram
+  static constexpr uint64_t kWindow = 1024;
+
+  // interval is how long a tick is meant to take
+  explicit TickStats(const Hoist::nanos_t interval);
+
+  TickStats(const TickStats&) = delete;
+  TickStats& operator=(const TickStats&) = delete;
+
+  // record how long a phase took
+  void put(const Phase phase, const Hoist::nanos_t nanos);
+  // record a whole update, which ran some steps and dropped others
+  void putTick(const Hoist::nanos_t nanos, const int steps,
+               const int64_t dropped);
+  // record how many entities there are after an update
+  void putEntities(const int64_t ships, const int64_t bullets,
+                   const int64_t explosions);
+
+  // get the running totals, only from the thread recording them
+  const PhaseTimes& totals() const { return totals_; }
+
+  // write a summary of recent ticks
+  void toProto(statusz::Ticks* ticks) const;
+
+ private:
+  typedef util::stats::Histogram<Hoist::nanos_t> Histogram;
+
+  const Hoist::nanos_t interval_;
+  PhaseTimes totals_;
+  Histogram tick_;
+  std::unique_ptr<Histogram> phases_[kNumPhases];
+  std::atomic<int64_t> count_;
+  std::atomic<int64_t> overruns_;
+  std::atomic<int64_t> dropped_;
+  std::atomic<int64_t> ships_;
+  std::atomic<int64_t> bullets_;
+  std::atomic<int64_t> explosions_;
+};
+
+}  // namespace spacefight
+
+#endif
@@ -0,0 +1,87 @@
+#include "net/spacefight/tick_stats.h"
+
+#include "gtest/gtest.h"
+
+namespace spacefight {
+namespace {
+
+const statusz::Latency* findLatency(const statusz::Ticks& ticks,
+                                    const std::string& name) {
+  for (const statusz::Latency& latency : ticks.latencies()) {
+    if (latency.name() == name) {
+      return &latency;
+    }
+  }
+  return nullptr;
+}
+
+TEST(TickStatsTest, SumsPhases) {
+  TickStats stats(100);
+  stats.put(TickStats::kInputs, 1);
+  stats.put(TickStats::kShips, 10);
+  stats.put(TickStats::kInputs, 1);
+  stats.put(TickStats::kShips, 20);
+  stats.put(TickStats::kSnapshot, 5);
+
+  const PhaseTimes& totals = stats.totals();
+  EXPECT_EQ(totals.steps, 2);
+  EXPECT_EQ(totals.snapshots, 1);
+  EXPECT_EQ(totals.inputs, 2);
+  EXPECT_EQ(totals.ships, 30);
+  EXPECT_EQ(totals.snapshot, 5);
+  EXPECT_EQ(totals.bullets, 0);
+}
+
+TEST(TickStatsTest, CountsOverruns) {
+  TickStats stats(100);
+  stats.putTick(50, 1, 0);
+  stats.putTick(100, 1, 0);
+  stats.putTick(150, 4, 3);
+
+  statusz::Ticks ticks;
+  stats.toProto(&ticks);
+  EXPECT_EQ(ticks.interval(), 100);
+  EXPECT_EQ(ticks.count(), 6);
+  EXPECT_EQ(ticks.overruns(), 1);
+  EXPECT_EQ(ticks.dropped(), 3);
+}
+
+TEST(TickStatsTest, SummarizesLatencies) {
+  TickStats stats(100);
+  for (int i = 1; i <= 100; i++) {
+    stats.putTick(i, 1, 0);
+    stats.put(TickStats::kBulletCollisions, i * 2);
+  }
+  stats.putEntities(3, 2, 1);
+
+  statusz::Ticks ticks;
+  stats.toProto(&ticks);
+  const statusz::Latency* tick = findLatency(ticks, "tick");
+  ASSERT_NE(tick, nullptr);
+  EXPECT_EQ(tick->samples(), 100);
+  EXPECT_EQ(tick->p50(), 50);
+  EXPECT_EQ(tick->p90(), 90);
+  EXPECT_EQ(tick->p99(), 99);
+  EXPECT_EQ(tick->max(), 100);
+
+  const statusz::Latency* collisions =
+      findLatency(ticks, "bullet_collisions");
+  ASSERT_NE(collisions, nullptr);
+  EXPECT_EQ(collisions->p50(), 100);
+
+  const statusz::Latency* ai = findLatency(ticks, "ai");
+  ASSERT_NE(ai, nullptr);
+  EXPECT_EQ(ai->samples(), 0);
+
+  EXPECT_EQ(ticks.entities().at("ships"), 3);
+  EXPECT_EQ(ticks.entities().at("bullets"), 2);
+  EXPECT_EQ(ticks.entities().at("explosions"), 1);
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
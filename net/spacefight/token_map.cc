@@ -0,0 +1,109 @@
+#include "net/spacefight/token_map.h"
+
+namespace spacefight {
+
+namespace {
+
+// entries a new map starts with
+constexpr size_t kInitialEntries = 64;
+
+}  // namespace
+
+TokenMap::TokenMap()
+    : entries_(kInitialEntries), mask_(kInitialEntries - 1), size_(0) {}
+
+uint64_t TokenMap::hash(const TokenKey& key) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < key.size; i++) {
+    h ^= static_cast<uint8_t>(key.bytes[i]);
+    h *= 1099511628211ULL;
+  }
+  // zero marks an empty entry
+  return h == 0 ? 1 : h;
+}
+
+size_t TokenMap::probe(const TokenKey& key, const uint64_t hash) const {
+  size_t i = hash & mask_;
+  while (entries_[i].hash != 0 &&
+         !(entries_[i].hash == hash && entries_[i].key == key)) {
+    i = (i + 1) & mask_;
+  }
+  return i;
+}
+
+void TokenMap::grow() {
+  std::vector<Entry> old(entries_.size() * 2);
+  old.swap(entries_);
+  mask_ = entries_.size() - 1;
+  for (const Entry& entry : old) {
+    if (entry.hash != 0) {
+      entries_[probe(entry.key, entry.hash)] = entry;
+    }
+  }
+}
+
+void TokenMap::set(const std::string& token, const int64_t player_id) {
+  TokenKey key;
+  if (!TokenKey::pack(token, &key)) {
+    return;
+  }
+  // keep at least half of the entries empty, so runs stay short
+  if ((size_ + 1) * 2 > entries_.size()) {
+    grow();
+  }
+  uint64_t h = hash(key);
+  Entry& entry = entries_[probe(key, h)];
+  if (entry.hash == 0) {
+    size_++;
+  }
+  entry.hash = h;
+  entry.player_id = player_id;
+  entry.key = key;
+}
+
+bool TokenMap::find(const std::string& token, int64_t* player_id) const {
+  TokenKey key;
+  if (!TokenKey::pack(token, &key)) {
+    return false;
+  }
+  const Entry& entry = entries_[probe(key, hash(key))];
+  if (entry.hash == 0) {
+    return false;
+  }
+  *player_id = entry.player_id;
+  return true;
+}
+
+bool TokenMap::erase(const std::string& token) {
+  TokenKey key;
+  if (!TokenKey::pack(token, &key)) {
+    return false;
+  }
+  size_t hole = probe(key, hash(key));
+  if (entries_[hole].hash == 0) {
+    return false;
+  }
+  // move back every later entry of the run that may not skip the hole
+  size_t i = hole;
+  while (true) {
+    i = (i + 1) & mask_;
+    const Entry& entry = entries_[i];
+    if (entry.hash == 0) {
+      break;
+    }
+    size_t home = entry.hash & mask_;
+    // whether home lies cyclically in (hole, i], in which case it stays
+    bool stays = hole <= i ? (hole < home && home <= i)
+                           : (hole < home || home <= i);
+    if (!stays) {
+      entries_[hole] = entry;
+      hole = i;
+    }
+  }
+  entries_[hole].hash = 0;
+  size_--;
+  return true;
+}
+
+}  // namespace spacefight
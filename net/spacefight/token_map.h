@@ -0,0 +1,75 @@
+#ifndef NET_SPACEFIGHT_TOKEN_MAP_H
+#define NET_SPACEFIGHT_TOKEN_MAP_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace spacefight {
+
+// longest session token, which is also the length of every token handed out
+static constexpr size_t kMaxTokenSize = 64;
+
+// TokenKey is a token packed into a fixed number of bytes, so that comparing
+// two tokens never follows a pointer. Bytes past the size are unspecified.
+struct TokenKey {
+  uint8_t size;
+  char bytes[kMaxTokenSize];
+
+  // pack a token, returning false if it is too long to ever be a token
+  static bool pack(const std::string& token, TokenKey* key) {
+    if (token.size() > kMaxTokenSize) {
+      return false;
+    }
+    key->size = token.size();
+    std::memcpy(key->bytes, token.data(), token.size());
+    return true;
+  }
+
+  bool operator==(const TokenKey& rhs) const {
+    return size == rhs.size && std::memcmp(bytes, rhs.bytes, size) == 0;
+  }
+};
+
+// TokenMap maps session tokens to player ids.
+//
+// Entries live inline in a single array and collisions probe the following
+// entries, so a lookup hashes the token once and then reads one or two
+// neighbouring cache lines. Removal shifts later entries of the same run
+// back, so the map never fills up with tombstones.
+class TokenMap final {
+ public:
+  TokenMap();
+
+  size_t size() const { return size_; }
+
+  // map a token to a player id, replacing any id it was mapped to
+  void set(const std::string& token, const int64_t player_id);
+  // look up the player id of a token, returning false if there is none
+  bool find(const std::string& token, int64_t* player_id) const;
+  // remove a token, returning false if there was none
+  bool erase(const std::string& token);
+
+ private:
+  struct Entry {
+    // zero for an empty entry, the hash of the token otherwise
+    uint64_t hash;
+    int64_t player_id;
+    TokenKey key;
+  };
+
+  static uint64_t hash(const TokenKey& key);
+  // get the entry of a key, or the empty entry where it would go
+  size_t probe(const TokenKey& key, const uint64_t hash) const;
+  void grow();
+
+  std::vector<Entry> entries_;
+  // entries_.size() - 1, entries_.size() is always a power of two
+  size_t mask_;
+  size_t size_;
+};
+
+}  // namespace spacefight
+
+#endif
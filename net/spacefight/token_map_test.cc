@@ -0,0 +1,96 @@
+#include "net/spacefight/token_map.h"
+
+#include <string>
+#include <unordered_map>
+#include "gtest/gtest.h"
+
+namespace spacefight {
+namespace {
+
+TEST(TokenMapTest, FindsWhatWasSet) {
+  TokenMap tokens;
+  tokens.set("alpha", 1);
+  tokens.set("beta", 2);
+
+  int64_t player_id = 0;
+  EXPECT_TRUE(tokens.find("alpha", &player_id));
+  EXPECT_EQ(player_id, 1);
+  EXPECT_TRUE(tokens.find("beta", &player_id));
+  EXPECT_EQ(player_id, 2);
+  EXPECT_FALSE(tokens.find("gamma", &player_id));
+  EXPECT_EQ(tokens.size(), 2);
+}
+
+TEST(TokenMapTest, SetReplaces) {
+  TokenMap tokens;
+  tokens.set("alpha", 1);
+  tokens.set("alpha", 7);
+
+  int64_t player_id = 0;
+  EXPECT_TRUE(tokens.find("alpha", &player_id));
+  EXPECT_EQ(player_id, 7);
+  EXPECT_EQ(tokens.size(), 1);
+}
+
+TEST(TokenMapTest, IgnoresTokensThatAreTooLong) {
+  TokenMap tokens;
+  std::string longest(kMaxTokenSize, 'a');
+  std::string too_long(kMaxTokenSize + 1, 'a');
+  tokens.set(longest, 1);
+  tokens.set(too_long, 2);
+
+  int64_t player_id = 0;
+  EXPECT_TRUE(tokens.find(longest, &player_id));
+  EXPECT_EQ(player_id, 1);
+  EXPECT_FALSE(tokens.find(too_long, &player_id));
+  EXPECT_FALSE(tokens.erase(too_long));
+  EXPECT_EQ(tokens.size(), 1);
+}
+
+TEST(TokenMapTest, TokensAreNotPrefixes) {
+  TokenMap tokens;
+  tokens.set("abc", 1);
+
+  int64_t player_id = 0;
+  EXPECT_FALSE(tokens.find("ab", &player_id));
+  EXPECT_FALSE(tokens.find("abcd", &player_id));
+  EXPECT_FALSE(tokens.find("", &player_id));
+}
+
+TEST(TokenMapTest, MatchesAnUnorderedMap) {
+  // grow, erase and reuse entries, checking every token after each change
+  TokenMap tokens;
+  std::unordered_map<std::string, int64_t> expected;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 1000; i++) {
+      std::string token = "token" + std::to_string(i);
+      tokens.set(token, i + round);
+      expected[token] = i + round;
+    }
+    for (int i = round; i < 1000; i += 3) {
+      std::string token = "token" + std::to_string(i);
+      EXPECT_TRUE(tokens.erase(token));
+      EXPECT_FALSE(tokens.erase(token));
+      expected.erase(token);
+    }
+    ASSERT_EQ(tokens.size(), expected.size());
+    for (int i = 0; i < 1000; i++) {
+      std::string token = "token" + std::to_string(i);
+      int64_t player_id = -1;
+      auto search = expected.find(token);
+      ASSERT_EQ(tokens.find(token, &player_id), search != expected.end())
+          << token;
+      if (search != expected.end()) {
+        EXPECT_EQ(player_id, search->second);
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace spacefight
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,16 @@
+#ifndef NET_SPACEFIGHT_UPDATE_CONTEXT_H
+#define NET_SPACEFIGHT_UPDATE_CONTEXT_H
+
+#include <grpc++/grpc++.h>
+
+namespace spacefight {
+
+// set up the server side of an Update stream, by either service
+inline void configureUpdateContext(grpc::ServerContext* context) {
+  // frames are already compressed once per tick, if at all
+  context->set_compression_level(GRPC_COMPRESS_LEVEL_NONE);
+}
+
+}  // namespace spacefight
+
+#endif
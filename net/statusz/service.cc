@@ -1,10 +1,15 @@
 #include "net/statusz/service.h"
 
 #include <sys/time.h>
+#include <utility>
 #include "net/statusz/memory.h"
 
 namespace statusz {
 
+void StatuszService::addProvider(StatusProvider provider) {
+  providers_.push_back(std::move(provider));
+}
+
 grpc::Status StatuszService::Poll(grpc::ServerContext* context,
                                   const commonpb::Empty* request,
                                   Status* response) {
@@ -16,6 +21,10 @@ grpc::Status StatuszService::Poll(grpc::ServerContext* context,
   unsigned long long timestamp = time(NULL);
   response->set_timestamp(timestamp);
 
+  for (const StatusProvider& provider : providers_) {
+    provider(response);
+  }
+
   return grpc::Status::OK;
 }
 
@@ -1,17 +1,29 @@
 #ifndef NET_STATUSZ_SERVICE_H
 #define NET_STATUSZ_SERVICE_H
 
+#include <functional>
+#include <vector>
 #include "proto/common/empty.pb.h"
 #include "proto/statusz/statusz.pb.h"
 #include "proto/statusz/statusz_service.grpc.pb.h"
 
 namespace statusz {
 
+// fills in the parts of a status that only a component of the server knows
+typedef std::function<void(Status*)> StatusProvider;
+
 class StatuszService final : public Statusz::Service {
  public:
+  // Add a provider to call on every poll.
+  // Providers must be added before the service starts serving.
+  void addProvider(StatusProvider provider);
+
   ::grpc::Status Poll(::grpc::ServerContext* context,
                       const commonpb::Empty* request,
                       Status* response) override;
+
+ private:
+  std::vector<StatusProvider> providers_;
 };
 
 }  // namespace statusz
@@ -6,6 +6,7 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <memory>
 #include "hoist/status_macros.h"
 
 namespace util {
@@ -20,6 +21,23 @@ StatusOr<MemFile*> MemFile::OpenMemFile(string path, size_t size) {
   return mem_file;
 }
 
+StatusOr<MemFile*> MemFile::OpenExistingMemFile(string path) {
+  // Opening would create the file if it is missing.
+  errno = 0;
+  if (access(path.c_str(), F_OK)) {
+    return ERRNO_AS_STATUS();
+  }
+  std::unique_ptr<MemFile> mem_file(new MemFile(path));
+  RETURN_IF_ERROR(mem_file->ReopenFile());
+  ASSIGN_OR_RETURN(size_t file_size, mem_file->FileSize());
+  if (file_size == 0) {
+    return Status(error::FAILED_PRECONDITION, "file is empty");
+  }
+  // Map all of the file.
+  RETURN_IF_ERROR(mem_file->MmapFd(file_size));
+  return mem_file.release();
+}
+
 Status MemFile::Resize(size_t size) {
   RETURN_IF_ERROR(ReopenFile());
   RETURN_IF_ERROR(Truncate(size));
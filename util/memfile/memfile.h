@@ -17,6 +17,8 @@ using ::std::string;
 class MemFile final {
  public:
   static StatusOr<MemFile*> OpenMemFile(string path, size_t size);
+  // OpenExistingMemFile maps the whole of a file that already has data.
+  static StatusOr<MemFile*> OpenExistingMemFile(string path);
 
   explicit MemFile(string path)
       : path_(path), fd_(kNoFd), size_(0), data_(nullptr) {}
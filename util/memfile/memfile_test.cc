@@ -62,6 +62,25 @@ TEST_F(MemFileTest, WriteFile) {
   EXPECT_EQ(s[2], 'c');
 }
 
+TEST_F(MemFileTest, OpenExistingFile) {
+  char* s = reinterpret_cast<char*>(file_->Data());
+  s[0] = 'a';
+  EXPECT_OK(file_->Sync());
+
+  auto result = MemFile::OpenExistingMemFile(kPath);
+  ASSERT_OK(result);
+  MemFile* existing = result.ValueOrDie();
+  EXPECT_EQ(existing->Size(), 10);
+  EXPECT_EQ(reinterpret_cast<char*>(existing->Data())[0], 'a');
+  delete existing;
+}
+
+TEST_F(MemFileTest, OpenMissingFile) {
+  auto result = MemFile::OpenExistingMemFile(kPath + ".missing");
+  EXPECT_FALSE(result.ok());
+  EXPECT_NE(access((kPath + ".missing").c_str(), F_OK), 0);
+}
+
 }  // namespace
 }  // namespace memfile
 }  // namespace util
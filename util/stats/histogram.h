@@ -6,6 +6,7 @@
 #include <cmath>
 #include <deque>
 #include <iostream>
+#include <mutex>
 #include <shared_mutex>
 #include <utility>
 #include <vector>
@@ -65,6 +66,11 @@ class Histogram {
 
   void Put(T value);
   void MakeHistogram(vector<Bucket<T>>& out) const;
+  // Get the value at each fraction (0 to 1) of the sorted values, using the
+  // nearest rank. out is empty if there are no values.
+  void Percentiles(const vector<double>& fractions, vector<T>& out) const;
+  // Get the number of values currently held.
+  uint64_t Size() const;
 
  private:
   static constexpr uint64_t DEFAULT_MAX_VALUES = 256;
@@ -172,6 +178,33 @@ void Histogram<T>::MakeHistogram(vector<Bucket<T>>& out) const {
   }
 }
 
+template <typename T>
+void Histogram<T>::Percentiles(const vector<double>& fractions,
+                               vector<T>& out) const {
+  out.clear();
+  vector<T> sorted;
+  {
+    shared_lock lock(mutex_);
+    sorted.assign(values_.begin(), values_.end());
+  }
+  if (sorted.size() == 0) {
+    return;
+  }
+  std::sort(sorted.begin(), sorted.end());
+
+  for (const double fraction : fractions) {
+    double rank = std::ceil(fraction * sorted.size());
+    size_t index = rank < 1 ? 0 : static_cast<size_t>(rank) - 1;
+    out.push_back(sorted[std::min(index, sorted.size() - 1)]);
+  }
+}
+
+template <typename T>
+uint64_t Histogram<T>::Size() const {
+  shared_lock lock(mutex_);
+  return values_.size();
+}
+
 }  // namespace stats
 }  // namespace util
 
@@ -55,6 +55,28 @@ TEST(HistogramTest, FullHistogram) {
   EXPECT_THAT(graph, ::testing::ContainerEq(expected));
 }
 
+TEST(HistogramTest, Percentiles) {
+  Histogram<int> h(50);
+  for (int i = 1; i <= 100; ++i) {
+    h.Put(i);
+  }
+
+  vector<int> percentiles;
+  h.Percentiles({0, 0.5, 0.9, 1}, percentiles);
+
+  EXPECT_EQ(h.Size(), 50);
+  EXPECT_THAT(percentiles, ::testing::ElementsAre(51, 75, 95, 100));
+}
+
+TEST(HistogramTest, EmptyPercentiles) {
+  Histogram<int> h;
+
+  vector<int> percentiles;
+  h.Percentiles({0.5}, percentiles);
+
+  EXPECT_TRUE(percentiles.empty());
+}
+
 }  // namespace
 }  // namespace stats
 }  // namespace util